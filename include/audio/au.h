@@ -2,6 +2,7 @@
 #include <core/def.h>
 #include <core/math.h>
 #include <core/hio.h>
+#include <vector>
 
 namespace flux::au
 {
@@ -14,6 +15,16 @@ enum device_option
     FX_AUDIO_MAX_DIST
 };
 
+// decoded pcm data, not uploaded to the device yet.
+// it can be made on any thread.
+struct wave
+{
+    std::vector<byte> pcm;
+    int samp_rate = 0;
+    int bps = 0;
+    int channels = 0;
+};
+
 struct track
 {
     /* unstable */ unsigned int __track_id;
@@ -59,6 +70,9 @@ struct clip
 
 void tk_make_device();
 void tk_end_make_device();
+shared<wave> load_wave(const hio_path &path);
+// upload the pcm data to the device. this should be called in the main thread.
+shared<track> make_track(shared<wave> wav);
 shared<track> load_track(const hio_path &path);
 shared<clip> make_clip(shared<track> track);
 
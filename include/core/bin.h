@@ -214,7 +214,7 @@ struct binary_array
 
     template <typename T> T get(int i, const T &def = T()) const
     {
-        if (i < 0 || i >= data.size())
+        if (i < 0 || (size_t)i >= data.size())
             return def;
         return data[i].cast<T>();
     }
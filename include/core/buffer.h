@@ -51,6 +51,7 @@ struct byte_buf
     byte_buf();
     byte_buf(size_t initial_size);
     byte_buf(const std::vector<byte> &vec);
+    byte_buf(std::vector<byte> &&vec);
 
     size_t size() const;
     size_t capacity() const;
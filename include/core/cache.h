@@ -0,0 +1,36 @@
+#pragma once
+#include <core/hio.h>
+#include <core/buffer.h>
+
+namespace flux
+{
+
+// what #asset_cache::fetch learned of a source, so that #asset_cache::store needs not to read it again.
+struct cache_stamp
+{
+    long long mtime = 0;
+    uint64_t chash = 0;
+    bool hashed = false;
+};
+
+// a directory of decoded blobs, so that warm starts skip decoding the sources.
+// entries are keyed by the source path, and validated by its mtime & content hash.
+struct asset_cache
+{
+    hio_path dir;
+    // compression of the blobs. decoded pixels compress well, but FX_COMP_NO is the fastest to read.
+    compression_level clvl = FX_COMP_NO;
+
+    // get the blob cached for #src into #out, with the read position at the payload.
+    // an uncompressed entry is handed over as read, with no copy.
+    // returns false if it is missing, stale or unreadable. then #stamp (if given) is filled for #store.
+    bool fetch(const hio_path &src, byte_buf &out, cache_stamp *stamp = nullptr);
+    // cache a blob for #src. it is safe to call from different threads for different sources.
+    // with the #stamp of a failed #fetch, the source is not read & hashed again.
+    void store(const hio_path &src, const byte_buf &blob, const cache_stamp *stamp = nullptr);
+    hio_path __entry(const hio_path &src) const;
+};
+
+shared<asset_cache> make_asset_cache(const hio_path &dir, compression_level clvl = FX_COMP_NO);
+
+} // namespace flux
@@ -0,0 +1,68 @@
+#pragma once
+#include <core/def.h>
+#include <core/math.h>
+#include <core/noise.h>
+#include <core/pool.h>
+#include <core/rand.h>
+#include <climits>
+#include <functional>
+#include <vector>
+
+namespace flux
+{
+
+// a generated square of the world.
+struct chunk
+{
+    int cx = 0, cy = 0;
+    // samples per side.
+    int size = 0;
+    // one grid per layer of the generator. sample (i, j) of layer l is layers[l][j * size + i].
+    std::vector<std::vector<float>> layers;
+};
+
+// a step run after the noise layers are sampled, e.g. to place ores or trees.
+// it runs on a worker thread, so it must only touch the chunk & the random it is given.
+// the random is seeded from the generator seed & the chunk coordinate, so its output is reproducible.
+using chunk_stage = std::function<void(chunk &c, random &rd)>;
+
+// generates chunks on a thread pool, and delivers them to the main thread.
+// pending chunks nearest to the #focus are generated first.
+// a chunk only depends on the seed & its coordinate, never on the thread count or the order of generation.
+struct chunk_gen
+{
+    struct _impl;
+    shared<_impl> __p;
+
+    long seed = 0;
+    int size = 32;
+    // world units per sample.
+    double scale = 1;
+    // each one fills a layer. they are sampled from several threads at once, so they must not keep state
+    // between calls (all noises of the engine don't).
+    std::vector<shared<noise>> layers;
+    std::vector<chunk_stage> stages;
+    shared<thread_pool> pool;
+    // called in #poll, on the main thread, for each finished chunk.
+    std::function<void(shared<chunk> c)> event_on_chunk;
+
+    chunk_gen();
+    ~chunk_gen();
+
+    // queue a chunk. chunks already queued, running or waiting for #poll are skipped.
+    void request(int cx, int cy);
+    // drop a chunk. if it is running, its result is thrown away.
+    void cancel(int cx, int cy);
+    void cancel_all();
+    // move the point (in world units) that queued chunks are prioritized by.
+    void focus(const vec2 &pos);
+    // deliver at most #max finished chunks. call it from the main thread, e.g. in the tick.
+    void poll(int max = INT_MAX);
+    // chunks requested, but not delivered yet. a chunk whose layers or stages throw is logged & dropped,
+    // so it leaves #pending, and can be requested again.
+    int pending() const;
+};
+
+shared<chunk_gen> make_chunk_gen(long seed, int size, double scale);
+
+} // namespace flux
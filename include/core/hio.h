@@ -50,6 +50,8 @@ bool hio_exists(const hio_path &path);
 void hio_mkdirs(const hio_path &path);
 // get the type of the path.
 hpath_type hio_judge(const hio_path &path);
+// get the last write time of a file. it is only comparable with other results of this function.
+long long hio_mtime(const hio_path &path);
 std::vector<hio_path> hio_sub_dirs(const hio_path &path);
 // get all files in the directory, but not in its sub-directories.
 std::vector<hio_path> hio_sub_files(const hio_path &path);
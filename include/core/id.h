@@ -1,10 +1,18 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <functional>
 
 namespace flux
 {
 
+// intern a string, and get its handle. the same string always gets the same handle.
+// it is thread-safe, and interned strings live until the process ends.
+uint32_t intern(std::string_view str);
+// get the interned string of a handle. the reference is stable.
+const std::string &interned(uint32_t handle);
+
 struct res_scope
 {
     std::string key;
@@ -13,21 +21,33 @@ struct res_scope
     res_scope(const std::string &key);
 };
 
+// an interned "scope:key" string. copying, comparing and hashing it are all integer operations.
+// note that the ordering is the interning order, not the lexicographic one.
 struct res_id
 {
-    res_scope scope;
-    std::string key;
-    std::string concat;
-    size_t __hash;
+    uint32_t __handle = 0;
+    // position of the ':' between the scope & the key: the last one of a "scope:key" string,
+    // or the one after the scope given to the constructor. npos if there is none.
+    uint32_t __split = UINT32_MAX;
 
     res_id();
     res_id(const std::string &cat);
     res_id(const res_scope &sc, const std::string &k);
     res_id(const char ch_arr[]);
 
+    const std::string &concat() const;
+    std::string scope() const;
+    std::string key() const;
+
     operator std::string() const;
-    bool operator ==(const res_id& other) const;
-    bool operator <(const res_id& other) const;
+    bool operator==(const res_id &other) const
+    {
+        return __handle == other.__handle;
+    }
+    bool operator<(const res_id &other) const
+    {
+        return __handle < other.__handle;
+    }
 };
 
 } // namespace flux
@@ -39,7 +59,8 @@ template <> struct hash<flux::res_id>
 {
     std::size_t operator()(const flux::res_id &id) const noexcept
     {
-        return id.__hash;
+        // fibonacci hashing spreads the sequential handles over the buckets.
+        return (std::size_t)(id.__handle * 0x9E3779B97F4A7C15ULL);
     }
 };
 
@@ -1,64 +1,185 @@
 #pragma once
 #include <core/hio.h>
 #include <core/id.h>
+#include <core/pool.h>
+#include <core/cache.h>
+#include <core/store.h>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <stack>
-#include <any>
+#include <chrono>
 #include <functional>
 
 namespace flux
 {
 
-std::unordered_map<res_id, std::any> *__get_resource_map();
+// check if a resource was loaded by a loader, and can be loaded again after eviction.
+bool __can_reload(const res_id &id);
+// load a resource again, synchronously. returns false if it cannot be reloaded.
+bool __reload(const res_id &id);
+
+void __trace_res(const res_id &id);
+
+// access tracing, to load the resources of later runs in the order the game needs them.
+// from #res_trace_begin, ids resolved by #make_res & #aref are recorded in order of first use.
+void res_trace_begin();
+// the ids recorded so far are needed for the first interactive frame. a loader ordered by the manifest dispatches
+// them first, finalizes them before others as soon as they are decoded, and tells when they are all done
+// (see #asset_loader::urgent_done).
+void res_trace_mark_urgent();
+// stop tracing, and write the manifest for #asset_loader::order_by.
+void res_trace_end(const hio_path &manifest);
+
+// a resolved resource id. dereferencing it is O(1), without any hashing.
+// a default-made handle refers to nothing: it is never done, and gets an empty value.
+template <typename T> struct res_handle
+{
+    int __handle = -1;
+
+    bool is_done() const
+    {
+        return __handle >= 0 && __get_res_store<T>().has(__handle);
+    }
+
+    T get() const
+    {
+        if (__handle < 0)
+            return T{};
+        return __get_res_store<T>().get(__handle);
+    }
+};
+
+template <typename T> res_handle<T> make_res_handle(const res_id &id)
+{
+    __trace_res(id);
+    return {__get_res_store<T>().resolve(id)};
+}
+
+// publish a resource. it can be called from any thread.
+// #bytes is its approximate memory cost. if positive, and the resource is reloadable,
+// it may be evicted when its type runs over the budget (see #set_res_budget).
+template <typename T> void put_res(const res_id &id, const T &v, size_t bytes = 0)
+{
+    auto &store = __get_res_store<T>();
+    store.put(store.resolve(id), v, bytes, bytes > 0 && __can_reload(id));
+}
+
+// limit the approximate memory of resources of type T.
+// evicted resources are reloaded when they are used through #aref.
+template <typename T> void set_res_budget(size_t bytes)
+{
+    auto &store = __get_res_store<T>();
+    store.budget = bytes;
+    store.evict();
+}
 
 // get a loaded resource by its id.
 // if you are unsure if the resource is loaded, use #make_res_ref instead.
+// if you look it up every frame, keep a #make_res_handle instead.
 template <typename T> T make_res(const res_id &id)
 {
-    const auto m = __get_resource_map();
-    auto it = m->find(id);
-    bool cf = it != m->end() && it->second.has_value();
-    return cf ? std::any_cast<T>(it->second) : std::decay_t<T>{};
+    return make_res_handle<T>(id).get();
 }
 
 template <typename T> struct aref
 {
     res_id id;
+    mutable res_handle<T> __h;
+
+    res_handle<T> __resolve() const
+    {
+        if (__h.__handle < 0)
+            __h = make_res_handle<T>(id);
+        return __h;
+    }
 
     bool is_done() const
     {
-        const auto m = __get_resource_map();
-        return m->find(id) != m->end();
+        return __resolve().is_done() || __can_reload(id);
     }
 
+    // if the resource was evicted, it is reloaded here, so use it in the main thread.
     operator T() const
     {
-        return make_res<T>(id);
+        auto h = __resolve();
+        if (!h.is_done())
+            __reload(id);
+        return h.get();
     }
 };
 
-using proc_strategy = std::function<void(const hio_path &path, const res_id &id)>;
+// the second stage of a task. it runs on the thread calling #next, so gl & al calls are safe here.
+using proc_finalizer = std::function<void()>;
+// the first stage of a task. it runs on a loader worker, decodes the file,
+// and returns the second stage (or nullptr if nothing is left to do).
+using proc_strategy = std::function<proc_finalizer(const hio_path &path, const res_id &id)>;
+
+struct asset_task
+{
+    res_id id;
+    std::function<proc_finalizer()> fn;
+};
 
 struct asset_loader
 {
     res_scope scope;
     hio_path root;
-    double progress;
-    int __done_tcount;
-    int __total_tcount;
+    // the progress counts the tasks of subloaders as well.
+    double progress = 0;
+    int __done_tcount = 0;
+    int __total_tcount = 0;
     std::map<std::string, proc_strategy> process_strategy_map;
-    std::stack<std::function<void()>> tasks;
+    std::stack<asset_task> tasks;
     std::vector<shared<asset_loader>> subloaders;
     std::function<void()> event_on_start;
     std::function<void()> event_on_end;
-    bool __start_called;
-    bool __end_called;
+    // called after each task, with the time spent in both stages. useful to find slow assets.
+    std::function<void(const res_id &id, std::chrono::microseconds decode, std::chrono::microseconds finalize)>
+        event_on_task;
+    bool __start_called = false;
+    bool __end_called = false;
+    // run on the main thread once all tasks are done, before #event_on_end.
+    std::vector<proc_finalizer> __finishers;
+    // from #order_by, the smaller the earlier. ranks under #__urgent_rank are urgent.
+    std::unordered_map<res_id, int> __rank;
+    int __urgent_rank = 0;
+    // the workers running the first stages, the global pool by default.
+    shared<thread_pool> pool;
+    // if set, built-in png & wave strategies read decoded blobs from it, and fill it on misses.
+    // the strategies take it when made, so set it before #make_loader_equipment.
+    shared<asset_cache> cache;
+
+    // shared with the workers, since they may outlive a dropped loader.
+    struct _impl;
+    shared<_impl> __p;
+
+    asset_loader();
+    ~asset_loader();
 
     void scan(const hio_path &path_root);
     void add_sub(shared<asset_loader> subloader);
-    // run a task in the queue.
+    // finish a task, blocking until one is decoded if necessary.
+    // tasks of this loader and its subloaders are decoded concurrently on #pool.
     // you may need to check the #progress to see if all tasks are done.
     void next();
+    // finish tasks until #budget is spent, without blocking past it.
+    // call it once a frame to keep the loading screen smooth.
+    void next_for(std::chrono::microseconds budget);
+
+    // schedule the tasks of this loader tree in the order of a manifest written by #res_trace_end.
+    // it does nothing if the manifest does not exist yet, like on the first run.
+    void order_by(const hio_path &manifest);
+    // whether the urgent tasks of the manifest are all finalized, e.g. to leave the loading screen early.
+    // it is false before the first #next, and true if there are none.
+    bool urgent_done() const;
+
+    bool __step(const std::chrono::steady_clock::time_point *deadline);
+    void __collect(std::vector<std::pair<asset_loader *, asset_task>> &out);
+    void __dispatch();
+    void __refresh();
+    int __count_done() const;
+    int __count_total() const;
 };
 
 // when you are unsure if the resource is loaded, use this to get a reference to it.
@@ -72,6 +193,9 @@ shared<asset_loader> make_loader(const res_scope &scope, const hio_path &root);
 enum asset_loader_equip
 {
     FX_LOAD_PNG_AS_TEXTURE,
+    // small pngs are packed into shared atlas pages when all tasks are done,
+    // and the resources are regions (#cut_texture) of the pages. large ones are plain textures.
+    FX_LOAD_PNG_AS_ATLAS,
     FX_LOAD_PNG_AS_IMAGE,
     FX_LOAD_TXT,
     FX_LOAD_FONT,
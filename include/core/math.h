@@ -1,6 +1,7 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
+#include <vector>
 
 namespace flux
 {
@@ -55,6 +56,57 @@ struct vec3
     static double dot(const vec3 &v1, const vec3 &v2);
 };
 
+// 2d vector in single precision, for bulk data (entities, particles, vertices).
+// it is used in hot loops, so everything is inlined.
+struct vec2f
+{
+    float x = 0;
+    float y = 0;
+
+    vec2f() = default;
+    vec2f(float x, float y) : x(x), y(y)
+    {
+    }
+    explicit vec2f(const vec2 &v) : x(float(v.x)), y(float(v.y))
+    {
+    }
+
+    operator vec2() const
+    {
+        return vec2(x, y);
+    }
+
+    vec2f operator+(const vec2f &v) const
+    {
+        return vec2f(x + v.x, y + v.y);
+    }
+    vec2f operator-(const vec2f &v) const
+    {
+        return vec2f(x - v.x, y - v.y);
+    }
+    vec2f operator*(const vec2f &v) const
+    {
+        return vec2f(x * v.x, y * v.y);
+    }
+    vec2f operator*(float s) const
+    {
+        return vec2f(x * s, y * s);
+    }
+    vec2f operator/(float s) const
+    {
+        return vec2f(x / s, y / s);
+    }
+
+    float length() const
+    {
+        return std::sqrt(x * x + y * y);
+    }
+    static float dot(const vec2f &v1, const vec2f &v2)
+    {
+        return v1.x * v2.x + v1.y * v2.y;
+    }
+};
+
 // 2x3 matrix for 2d transformations (called an affine matrix)
 struct transform
 {
@@ -71,6 +123,9 @@ struct transform
     float det() const;
     transform get_invert() const;
     void apply(vec2 &v) const;
+    // apply to #n points, packed as x0, y0, x1, y1, ... in float precision.
+    // #xy_out can be the same array as #xy_in.
+    void apply_many(const float *xy_in, float *xy_out, int n) const;
     transform &translate(float tx, float ty);
     transform &scale(float sx, float sy);
     transform &rotate(float rad);
@@ -110,4 +165,74 @@ struct quad
     double area() const;
 };
 
+// quad in single precision. see #vec2f.
+struct quadf
+{
+    float x = 0, y = 0, width = 0, height = 0;
+
+    quadf() = default;
+    quadf(float x, float y, float w, float h) : x(x), y(y), width(w), height(h)
+    {
+    }
+    explicit quadf(const quad &q) : x(float(q.x)), y(float(q.y)), width(float(q.width)), height(float(q.height))
+    {
+    }
+
+    operator quad() const
+    {
+        return quad(x, y, width, height);
+    }
+
+    float prom_x() const
+    {
+        return x + width;
+    }
+    float prom_y() const
+    {
+        return y + height;
+    }
+    float center_x() const
+    {
+        return x + width * 0.5f;
+    }
+    float center_y() const
+    {
+        return y + height * 0.5f;
+    }
+    static bool intersect(const quadf &q1, const quadf &q2)
+    {
+        return q1.x < q2.prom_x() && q2.x < q1.prom_x() && q1.y < q2.prom_y() && q2.y < q1.prom_y();
+    }
+    static bool contain(const quadf &q, const vec2f &v)
+    {
+        return v.x >= q.x && v.x <= q.prom_x() && v.y >= q.y && v.y <= q.prom_y();
+    }
+};
+
+// points as separate x & y arrays (structure of arrays), for bulk work over many points.
+// a simd register holds 4 or 8 x (or y) of neighbouring points, rather than 2 or 4 interleaved ones.
+struct vec2_soa
+{
+    std::vector<float> xs;
+    std::vector<float> ys;
+
+    int size() const;
+    void resize(int n);
+    void reserve(int n);
+    void clear();
+    // returns the index of the new point.
+    int push(const vec2f &v);
+    vec2f get(int i) const;
+    void set(int i, const vec2f &v);
+    // move the last point into #i. it does not keep the order.
+    void swap_remove(int i);
+
+    void translate(float dx, float dy);
+    void apply(const transform &t);
+    // write the points into #xy, packed as x0, y0, x1, y1, ... (see transform::apply_many).
+    void pack(float *xy) const;
+    // replace the points with #n packed ones.
+    void unpack(const float *xy, int n);
+};
+
 } // namespace flux
@@ -0,0 +1,73 @@
+#pragma once
+#include <core/def.h>
+#include <core/math.h>
+#include <core/rand.h>
+
+namespace flux
+{
+
+struct noise
+{
+    long seed;
+    virtual ~noise() = default;
+    virtual double generate(double x, double y, double z) = 0;
+    // sample a grid of #nx * #ny * #nz points, starting at #origin and stepping by #step on each axis.
+    // #out is filled x-fastest, i.e. out[(k * ny + j) * nx + i] is the sample at origin + step * (i, j, k).
+    // the default one calls #generate per sample. noises with a faster path override it.
+    virtual void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out);
+    // sample #n scattered points, (x[i], y[i], z[i]) into out[i].
+    virtual void generate_points(const double *x, const double *y, const double *z, int n, float *out);
+};
+
+// cellular noise. #generate gives the value of the cell nearest to the point.
+struct voronoi : noise
+{
+    // like #generate_grid, but also gives the distances to the nearest (f1) and the second nearest (f2) feature
+    // points. any of #f1, #f2 and #cell can be null if not needed.
+    virtual void generate_cells(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *f1, float *f2,
+                                float *cell) = 0;
+};
+
+shared<noise> make_perlin(long seed);
+// simplex noise, in [0, 1]. the 2d one ignores z, and only walks 3 corners per sample (perlin noise walks 8).
+shared<noise> make_simplex2(long seed);
+shared<noise> make_simplex3(long seed);
+shared<voronoi> make_voronoi(long seed);
+
+// a node of a noise graph. nodes are made by the noise_* functions below, and compiled by #make_noise_graph.
+// nodes can be shared by several parents, then they are evaluated once.
+struct noise_node;
+
+// samples #src at p * #freq.
+shared<noise_node> noise_source(shared<noise> src, double freq = 1);
+// fractal brownian motion: #octaves layers of #src, each one at #lacunarity times the frequency
+// and #gain times the weight of the last. the weighted average is returned, in [0, 1] for sources in [0, 1].
+shared<noise_node> noise_fbm(shared<noise> src, int octaves, double freq = 1, double lacunarity = 2, double gain = 0.5);
+// ridged multifractal: like fbm, but each octave is folded into sharp ridges and weighted by the octave before it.
+shared<noise_node> noise_ridged(shared<noise> src, int octaves, double freq = 1, double lacunarity = 2,
+                                double gain = 0.5);
+// evaluates #in at p + (2 * w - 1) * #amp, where w is (#wx, #wy, #wz) at p. a null #wz leaves z as it is.
+shared<noise_node> noise_warp(shared<noise_node> in, shared<noise_node> wx, shared<noise_node> wy,
+                              shared<noise_node> wz, double amp);
+// maps [#from_min, #from_max] to [#to_min, #to_max] linearly, and clamps the result into it.
+shared<noise_node> noise_remap(shared<noise_node> in, double from_min, double from_max, double to_min, double to_max);
+shared<noise_node> noise_add(shared<noise_node> a, shared<noise_node> b);
+shared<noise_node> noise_mul(shared<noise_node> a, shared<noise_node> b);
+shared<noise_node> noise_const(double v);
+
+// compile a graph into a flat program, wrapped as a noise.
+// it runs over blocks of a few dozen samples, so intermediate values stay in a small scratch,
+// and no node ever holds a whole grid.
+shared<noise> make_noise_graph(shared<noise_node> root);
+
+// wrap #src with a cache of evaluated tiles, for noises sampled at the same points by several systems.
+// #src is sampled on a lattice of #cell spacing (in x & y), #tile * #tile points per tile.
+// points on the lattice (and grids stepping by #cell from a lattice point) are read from the cache,
+// other points go straight to #src. at most #max_tiles tiles are kept, least-recently-used ones are dropped.
+// tiles are filled by #src's #generate_grid, so cached points match its grids, and differ from its #generate
+// by the float error of its grid path (e.g. 2.5e-6 for simplex2).
+// the cache is split into 16 shards with their own locks, so generator threads rarely wait for each other.
+// #max_tiles is split among them, so with fewer than 16 tiles some shards keep none.
+shared<noise> make_noise_cache(shared<noise> src, double cell, int tile = 32, int max_tiles = 1024);
+
+} // namespace flux
@@ -0,0 +1,29 @@
+#pragma once
+#include <core/def.h>
+#include <functional>
+
+namespace flux
+{
+
+// a fixed group of worker threads. each worker has its own job queue, and steals from the others when it runs dry.
+// jobs submitted from outside are spread over the queues round-robin, and each queue runs in fifo order.
+// jobs submitted from a worker go to its own queue, so follow-up jobs stay on the same core.
+struct thread_pool
+{
+    struct _impl;
+    unique<_impl> __p;
+
+    thread_pool(int threads);
+    ~thread_pool();
+
+    // queue a job. it will run on one of the workers later.
+    // jobs must not touch gl or al, since the contexts live on the main thread.
+    void submit(std::function<void()> job);
+    int size() const;
+};
+
+// get the global pool, sized to the core count (one core is left to the main thread).
+shared<thread_pool> get_gpool();
+shared<thread_pool> make_pool(int threads);
+
+} // namespace flux
@@ -5,6 +5,9 @@
 namespace flux
 {
     
+// a xoshiro256** generator. the whole state lives in the instance, so
+// instances are independent, and the same seed always gives the same sequence.
+// an instance is not meant to be shared across threads: use #split to give each thread its own stream.
 struct random
 {
     struct _impl;
@@ -16,6 +19,8 @@ struct random
     // here, the implementation may be complicated.
     // but this single seed provides randomness.
     void set_seed(long seed);
+    // seed with all 64 bits, even where long is 32-bit. equal to #set_seed where long is 64-bit.
+    void set_seed_bits(uint64_t seed);
 
     // equivalent to next() < 0.5.
     bool next_bool();
@@ -25,7 +30,21 @@ struct random
     double next_guassian(double min, double max);
     int next_int(int bound);
     int next_int(int min, int max);
+    // raw 64 random bits.
+    uint64_t next_bits();
 
+    // fill #out with #n values of next().
+    void next_many(double *out, int n);
+    // fill #out with #n values of next_int(bound).
+    void next_int_many(int *out, int n, int bound);
+
+    // advance the state by 2^128 draws.
+    void jump();
+    // returns a generator at the current state, and jumps this one.
+    // streams split this way never overlap, so they can be handed to worker threads.
+    shared<random> split();
+
+    // the full state is written, so a read generator continues the exact sequence.
     void write(byte_buf& buf);
     void read(byte_buf& buf);
 
@@ -34,19 +53,10 @@ struct random
 };
 
 // get a global random generator, when we don't care the seed.
+// each thread has its own one.
 shared<random> get_grand();
 // make a new random generator, with a random seed or a specific seed.
 shared<random> make_random();
 shared<random> make_random(long seed);
 
-struct noise
-{
-    long seed;
-    virtual ~noise() = default;
-    virtual double generate(double x, double y, double z) = 0;
-};
-
-shared<noise> make_perlin(long seed);
-shared<noise> make_voronoi(long seed);
-
 } // namespace flux
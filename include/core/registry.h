@@ -1,9 +1,10 @@
 #pragma once
-#include <map>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 #include <core/id.h>
 #include <core/def.h>
-#include <functional>
-#include <stack>
+#include <core/log.h>
 
 namespace flux
 {
@@ -17,45 +18,90 @@ template <typename T> struct ref
 
     operator T()
     {
-        return *reg[idx];
+        return (*reg)[idx];
     }
 };
 
+// entries live in a contiguous vector, indexed by their reg_index.
+// the reg_index is stable, so network sync & save files can refer to entries by it.
 template <typename T> struct registry
 {
-    std::map<res_id, T> map;
-    std::stack<std::function<void()>> __delayed;
-    int __idx_next = 0;
+    std::vector<T> entries;
+    std::unordered_map<res_id, int> index;
+    // after #work, ids are looked up by binary search over the sorted interned handles of the entries.
+    // it only holds this registry's ids, so it costs nothing for the strings interned elsewhere.
+    std::vector<uint32_t> __frozen_handles;
+    std::vector<int> __frozen;
+    bool __is_frozen = false;
 
     ref<T> make(const res_id &id, const T &obj)
     {
-        map[id] = obj;
-        int idx = __idx_next++;
+        if (__is_frozen)
+            prtlog_throw(FX_FATAL, "registry is frozen, cannot make {}.", std::string(id));
+
+        auto it = index.find(id);
+        int idx = it == index.end() ? (int)entries.size() : it->second;
+        if (idx == (int)entries.size())
+            entries.push_back(obj);
+        else
+            entries[idx] = obj;
+        index[id] = idx;
+
         // here, the template value should have members reg_index & reg_id.
-        __delayed.push([this, idx, id]() {
-            map[id].reg_index = idx;
-            map[id].reg_id = id;
-        });
-         return {this, idx};
+        entries[idx].reg_index = idx;
+        entries[idx].reg_id = id;
+        return {this, idx};
     }
 
+    // freeze the registry. no entries can be made after it.
     void work()
     {
-        while(!__delayed.empty())
+        std::vector<std::pair<uint32_t, int>> pairs;
+        pairs.reserve(index.size());
+        for (auto &[id, idx] : index)
+            pairs.push_back({id.__handle, idx});
+        std::sort(pairs.begin(), pairs.end());
+
+        __frozen_handles.resize(pairs.size());
+        __frozen.resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++)
         {
-            __delayed.top()();
-            __delayed.pop();
+            __frozen_handles[i] = pairs[i].first;
+            __frozen[i] = pairs[i].second;
         }
+        __is_frozen = true;
+    }
+
+    // get the reg_index of an id, or -1 if not found.
+    int index_of(const res_id &id) const
+    {
+        if (__is_frozen)
+        {
+            auto it = std::lower_bound(__frozen_handles.begin(), __frozen_handles.end(), id.__handle);
+            if (it == __frozen_handles.end() || *it != id.__handle)
+                return -1;
+            return __frozen[it - __frozen_handles.begin()];
+        }
+        auto it = index.find(id);
+        return it == index.end() ? -1 : it->second;
+    }
+
+    int size() const
+    {
+        return (int)entries.size();
     }
 
-    T operator[](int idx)
+    T &operator[](int idx)
     {
-        return map[idx];
+        return entries[idx];
     }
 
-    T operator[](const res_id &id)
+    T &operator[](const res_id &id)
     {
-        return map[id];
+        int idx = index_of(id);
+        if (idx < 0)
+            prtlog_throw(FX_FATAL, "{} is not registered.", std::string(id));
+        return entries[idx];
     }
 };
 
@@ -0,0 +1,36 @@
+#pragma once
+
+// x86 intrinsics are used where they exist. the makefile does not pass -mavx2 & co., so simd paths
+// beyond sse2 are compiled per function with FX_TARGET, and must check the cpu at runtime before running.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FX_X86
+#include <immintrin.h>
+#define FX_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace flux
+{
+
+// avx2 together with fma.
+inline bool cpu_has_avx2()
+{
+#if defined(FX_X86)
+    static bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has;
+#else
+    return false;
+#endif
+}
+
+// f16c together with avx.
+inline bool cpu_has_f16c()
+{
+#if defined(FX_X86)
+    static bool has = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+    return has;
+#else
+    return false;
+#endif
+}
+
+} // namespace flux
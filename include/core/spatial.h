@@ -0,0 +1,73 @@
+#pragma once
+#include <core/def.h>
+#include <core/math.h>
+#include <functional>
+
+namespace flux
+{
+
+// finds objects by their bounding quads, without scanning all of them.
+// objects are addressed by integer handles, stable until the object is removed (then the handle is reused).
+// boxes touching at an edge count as intersecting, so zero-sized boxes (points) work too.
+// queries don't modify the index, so several threads can query at once, as long as none inserts, moves or removes.
+struct spatial_index
+{
+    virtual ~spatial_index() = default;
+    // returns the handle of the new object. #user is kept for the caller, e.g. an entity id.
+    virtual int insert(const quad &box, long user = 0) = 0;
+    virtual void move(int handle, const quad &box) = 0;
+    virtual void remove(int handle) = 0;
+    virtual void clear() = 0;
+    // write the handles of the objects intersecting #region into #out, at most #cap of them.
+    // returns how many there are, which can be more than #cap (then only #cap are written).
+    virtual int query(const quad &region, int *out, int cap) const = 0;
+    // like #query, for the objects containing #p.
+    virtual int query_point(const vec2 &p, int *out, int cap) const = 0;
+    virtual quad box_of(int handle) const = 0;
+    virtual long user_of(int handle) const = 0;
+    virtual int size() const = 0;
+};
+
+// a uniform grid of #cell sized squares, hashed so it is unbounded. objects are listed in every cell they touch,
+// so it suits dense, moving objects of about the cell size. a move inside the same cells only updates the box.
+// objects spanning too many cells are kept in a list checked by every query instead.
+shared<spatial_index> make_hash_grid(double cell);
+// a loose quadtree over #bounds: each node accepts objects up to its size whose center is inside it, and its
+// bounds are twice as large as its area. an object is placed in one node, found directly from its size & center.
+// it suits sparse or static objects of very different sizes. objects out of #bounds are kept at the root.
+shared<spatial_index> make_quadtree(const quad &bounds, int max_depth = 8);
+
+// a sort-and-sweep broadphase: finds the pairs of intersecting boxes, and reports when pairs start or stop to
+// intersect. box endpoints are kept sorted on both axes between ticks, and re-sorted by insertion sort in #update,
+// so a tick where boxes move a little costs about linear time.
+// handles are like the ones of spatial_index, except a removed handle is reused only after the next #update.
+struct sweep_prune
+{
+    struct _impl;
+    shared<_impl> __p;
+
+    // called in #update for each pair that starts / stops to intersect, with a < b.
+    // pairs are reported in order, and a pair starting & stopping in between two updates is not reported.
+    // the pairs of a removed object are ended in the next #update, with its handle still readable during the call
+    // (#box_of, #user_of), though it cannot be moved or removed again.
+    std::function<void(int a, int b)> event_on_begin;
+    std::function<void(int a, int b)> event_on_end;
+
+    sweep_prune();
+    ~sweep_prune();
+
+    // changes take effect in the next #update.
+    int insert(const quad &box, long user = 0);
+    void move(int handle, const quad &box);
+    void remove(int handle);
+    void update();
+    // whether #a & #b intersect, as of the last #update.
+    bool overlapping(int a, int b) const;
+    quad box_of(int handle) const;
+    long user_of(int handle) const;
+    int size() const;
+};
+
+shared<sweep_prune> make_sweep_prune();
+
+} // namespace flux
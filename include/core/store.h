@@ -0,0 +1,176 @@
+#pragma once
+#include <core/id.h>
+#include <core/log.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace flux
+{
+
+// a tiny lock for a single slot. slots are rarely contended, and a mutex per slot is too fat.
+struct __slot_lock
+{
+    std::atomic_flag flag;
+
+    void lock()
+    {
+        while (flag.test_and_set(std::memory_order_acquire))
+            flag.wait(true, std::memory_order_relaxed);
+    }
+
+    void unlock()
+    {
+        flag.clear(std::memory_order_release);
+        flag.notify_one();
+    }
+};
+
+// resources of one type, in dense slots addressed by stable integer handles.
+// slots never move once allocated, so a handle is dereferenced without hashing or locking the store.
+// it is safe to read from any thread while others publish.
+// when the approximate #bytes_used exceeds the #budget, least-recently-used evictable slots are emptied.
+template <typename T> struct res_store
+{
+    static constexpr int CHUNK_BITS = 8;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static constexpr int MAX_CHUNKS = 4096;
+
+    struct slot
+    {
+        __slot_lock lck;
+        bool has_value = false;
+        // only entries that can be reloaded are evictable.
+        bool evictable = false;
+        size_t bytes = 0;
+        uint64_t last_use = 0;
+        T value{};
+    };
+
+    std::atomic<slot *> chunks[MAX_CHUNKS]{};
+    std::unordered_map<res_id, int> index;
+    std::shared_mutex mtx;
+    int __slot_next = 0;
+    std::atomic<size_t> bytes_used = 0;
+    std::atomic<size_t> budget = SIZE_MAX;
+    std::atomic<uint64_t> __clock = 0;
+
+    ~res_store()
+    {
+        for (auto &c : chunks)
+            delete[] c.load();
+    }
+
+    slot &__at(int handle)
+    {
+        return chunks[handle >> CHUNK_BITS].load(std::memory_order_acquire)[handle & (CHUNK_SIZE - 1)];
+    }
+
+    // get the handle of #id, making an empty slot for it if not seen yet.
+    int resolve(const res_id &id)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lk(mtx);
+            auto it = index.find(id);
+            if (it != index.end())
+                return it->second;
+        }
+
+        std::unique_lock<std::shared_mutex> lk(mtx);
+        auto it = index.find(id);
+        if (it != index.end())
+            return it->second;
+
+        int handle = __slot_next++;
+        if ((handle >> CHUNK_BITS) >= MAX_CHUNKS)
+            prtlog_throw(FX_FATAL, "too many resources of a type.");
+        if ((handle & (CHUNK_SIZE - 1)) == 0)
+            chunks[handle >> CHUNK_BITS].store(new slot[CHUNK_SIZE], std::memory_order_release);
+        index[id] = handle;
+        return handle;
+    }
+
+    void put(int handle, const T &v, size_t bytes = 0, bool evictable = false)
+    {
+        slot &s = __at(handle);
+        T old;
+        {
+            std::lock_guard<__slot_lock> lk(s.lck);
+            old = std::move(s.value);
+            bytes_used -= s.bytes;
+            bytes_used += bytes;
+            s.value = v;
+            s.has_value = true;
+            s.evictable = evictable;
+            s.bytes = bytes;
+            s.last_use = ++__clock;
+        }
+
+        if (bytes_used > budget)
+            evict(handle);
+    }
+
+    // returns a default value if nothing is published yet.
+    T get(int handle)
+    {
+        slot &s = __at(handle);
+        std::lock_guard<__slot_lock> lk(s.lck);
+        s.last_use = __clock.fetch_add(1, std::memory_order_relaxed) + 1;
+        return s.value;
+    }
+
+    // empty least-recently-used slots until the store fits in #budget.
+    // the values are released in the calling thread (note: for gl resources, it must be the main thread).
+    void evict(int keep = -1)
+    {
+        std::vector<std::pair<uint64_t, int>> lru;
+        {
+            std::shared_lock<std::shared_mutex> lk(mtx);
+            for (int h = 0; h < __slot_next; h++)
+            {
+                slot &s = __at(h);
+                std::lock_guard<__slot_lock> slk(s.lck);
+                if (s.has_value && s.evictable && h != keep)
+                    lru.push_back({s.last_use, h});
+            }
+        }
+        std::sort(lru.begin(), lru.end());
+
+        for (auto &[t, h] : lru)
+        {
+            if (bytes_used <= budget)
+                break;
+            slot &s = __at(h);
+            // declared before the lock, so that it is released after unlocking.
+            T old;
+            std::lock_guard<__slot_lock> lk(s.lck);
+            // touched since collected, give it a chance.
+            if (!s.has_value || s.last_use != t)
+                continue;
+            old = std::move(s.value);
+            s.value = T{};
+            s.has_value = false;
+            bytes_used -= s.bytes;
+            s.bytes = 0;
+        }
+    }
+
+    bool has(int handle)
+    {
+        slot &s = __at(handle);
+        std::lock_guard<__slot_lock> lk(s.lck);
+        return s.has_value;
+    }
+};
+
+template <typename T> res_store<T> &__get_res_store()
+{
+    static res_store<T> store;
+    return store;
+}
+
+} // namespace flux
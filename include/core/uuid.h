@@ -1,27 +1,30 @@
 #pragma once
-#include <vector>
+#include <array>
+#include <cstdint>
+#include <string>
 #include <core/def.h>
-#include <core/rand.h>
 
 namespace flux
 {
 
+// a 16-byte id, stored inline. copying it never allocates.
 struct uuid
 {
-    std::vector<byte> bytes = std::vector<byte>(16, (byte)0);
-    size_t __hash;
-
-    uuid() = default;
+    std::array<byte, 16> bytes{};
 
     bool operator==(const uuid &other) const;
+    // uuids made by #uuid_generate are ordered by their making time (in milliseconds).
     bool operator<(const uuid &other) const;
     operator std::string() const;
+    // fold the 128 bits into 64.
+    size_t hash() const;
 };
 
 // returns a null uuid, all bytes are 0.
 uuid uuid_null();
-// generate a random uuid with current time and a random number from #get_grand.
-// hopefully they won't collide.
+// generate a time-ordered uuid (the uuid v7 layout): 48 bits of unix milliseconds,
+// a per-thread sequence in the same millisecond, and random bits.
+// it is lock-free, and can be called from any thread.
 uuid uuid_generate();
 
 } // namespace flux
@@ -33,8 +36,8 @@ template <> struct hash<flux::uuid>
 {
     std::size_t operator()(const flux::uuid &id) const noexcept
     {
-        return id.__hash;
+        return id.hash();
     }
 };
 
-} // namespace std
\ No newline at end of file
+} // namespace std
@@ -23,6 +23,8 @@ struct atlas
     void end();
     // add an image to the atlas, and get its texture.
     shared<texture> accept(shared<image> image);
+    // like #accept, but returns nullptr instead of throwing when the atlas is full.
+    shared<texture> try_accept(shared<image> image);
     // write an image to the atlas.
     void imgcpy(shared<image> image, int dest_x, int dest_y);
 };
@@ -7,6 +7,7 @@
 #include <core/math.h>
 #include <core/math.h>
 #include <stack>
+#include <vector>
 #include <functional>
 
 namespace flux::gfx
@@ -37,9 +38,29 @@ struct graph_state
 // pre-declare
 struct mesh;
 
+// a draw recorded in deferred mode. its vertices are kept in brush::__dverts.
+struct __draw_cmd
+{
+    int layer;
+    // gl ids, 0 for the default program (of the mode) / no texture.
+    unsigned int program;
+    unsigned int texture;
+    blend_mode blend;
+    graph_mode mode;
+    // index in brush::__dstates.
+    int state;
+    size_t offset;
+    int bytes;
+    int vertices;
+    int indices;
+};
+
 struct brush
 {
+    // change it by cl_* only, as the encoded copy is kept by them.
     color vertex_color[4]{};
+    // #vertex_color, as half floats (r, g, b, a) for the vertices.
+    half __vertex_half[4][4]{};
     std::stack<transform> transform_stack;
     camera camera_binded;
     graph_state m_state;
@@ -50,6 +71,14 @@ struct brush
     bool __is_in_mesh = false;
     // when true, the brush will clear the buffer when flushed.
     bool __clear_when_flush = true;
+    blend_mode __blend = FX_NORMAL_BLEND;
+    bool __deferred = false;
+    int __layer = 0;
+    std::vector<__draw_cmd> __queue;
+    std::vector<byte> __dverts;
+    // the states the queued draws are made in. a new one is taken only when the texture or program changes.
+    std::vector<graph_state> __dstates;
+    bool __dstate_stale = true;
     
     brush();
 
@@ -60,6 +89,7 @@ struct brush
     void cl_set(const color &col);
     void cl_mrg(const color &col);
     void cl_mrg(double v);
+    void __encode_color();
     void ts_push();
     void ts_pop();
     void ts_load(const transform &t);
@@ -70,7 +100,23 @@ struct brush
     void ts_rot(const vec2 &v, double r);
     transform get_combined_transform();
 
+    // draw what is in the buffer, and in deferred mode, the queued draws before it.
     void flush();
+    void __flush_buffer();
+    // enter deferred mode: draws are queued as commands rather than written to the buffer, and at #flush they are
+    // stably sorted by (layer, program, texture, blend mode), then merged into as few draw calls as possible.
+    // so draws in the same layer can be reordered; set a #layer where the order matters, e.g. text over sprites.
+    // the transform stack is applied when a draw is queued. camera, viewport & scissor changes flush the queue.
+    // uniforms set by graph_state::callback_uniform are taken from the first draw of each batch.
+    void begin_deferred();
+    // flush, and go back to drawing at once.
+    void end_deferred();
+    // the layer of the next draws in deferred mode. lower layers are drawn first.
+    void layer(int l);
+    template <typename V> void __emit(V *vs, int n, bool quad);
+    int __dstate_index();
+    void __submit();
+    void __apply_blend(blend_mode mode);
     void assert_mode(graph_mode mode);
     void assert_texture(shared<texture> tex);
     void use(const camera &cam);
@@ -28,6 +28,10 @@ struct camera
     void project(vec2 &v);
     // project screen coordinates to world coordinates.
     void unproject(vec2 &v);
+    // like #project & #unproject, for #n points packed as x0, y0, x1, y1, ... (see transform::apply_many).
+    // the whole mapping is folded into one transform, so it is a single pass over the points.
+    void project_many(const float *xy_in, float *xy_out, int n);
+    void unproject_many(const float *xy_in, float *xy_out, int n);
     double project_x(double x);
     double project_y(double y);
     double unproject_x(double x);
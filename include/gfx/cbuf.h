@@ -1,8 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <cstring>
 #include <gfx/image.h>
 #include <gfx/shader.h>
+#include <gfx/vertex.h>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace flux::gfx
@@ -24,11 +27,10 @@ enum graph_mode
 struct complex_buffer
 {
     std::vector<byte> vertex_buf;
-    std::vector<unsigned int> index_buf;
     int vertex_count = 0;
+    // quads are indexed by the shared #quad_index_buffer, so only the count is kept.
     int index_count = 0;
     bool dirty;
-    bool __icap_changed;
     bool __vcap_changed;
 
     // write a vertex, generally, T is float.
@@ -49,20 +51,33 @@ struct complex_buffer
         return *this;
     }
 
-    // write an index.
-    inline complex_buffer & idx(unsigned int t)
+    // make room for #bytes more vertex data, with at most one reallocation.
+    inline void __reserve_vtx(size_t bytes)
     {
-        size_t s = sizeof(t);
-        size_t old = index_buf.size();
-        if(old + s > index_buf.capacity())
+        size_t need = vertex_buf.size() + bytes;
+        if (need > vertex_buf.capacity())
         {
-            index_buf.reserve(index_buf.capacity() * 2);
-            __icap_changed = true;
+            vertex_buf.reserve(std::max(need, vertex_buf.capacity() * 2));
+            __vcap_changed = true;
         }
-    
-        index_buf.push_back(t);
+    }
+
+    // write whole vertices (see gfx/vertex.h), and count them like #new_vertex.
+    template <typename V> complex_buffer &push_vertices(std::span<const V> vs)
+    {
+        const byte *src = reinterpret_cast<const byte *>(vs.data());
+        __reserve_vtx(vs.size_bytes());
+        vertex_buf.insert(vertex_buf.end(), src, src + vs.size_bytes());
+        vertex_count += (int)vs.size();
         dirty = true;
+        return *this;
+    }
 
+    // write the 4 corners of a quad, and its indices. the corners go in the order #end_quad expects.
+    template <typename V> complex_buffer &emplace_quad(const V (&vs)[4])
+    {
+        push_vertices(std::span<const V>(vs, 4));
+        new_index(6);
         return *this;
     }
 
@@ -74,4 +89,10 @@ struct complex_buffer
 
 shared<complex_buffer> make_buffer();
 
+// the index buffer shared by all quad batches. quad i is made of the vertices 4i .. 4i + 3, in the order
+// #end_quad expects. the indices never change, so they are generated once, and regenerated only when a batch
+// needs more than #quads. a vao keeps the element buffer bound, so it is bound to each vao once.
+// note: growing it binds it to the current vao. call it on the main thread, with a gl context.
+unsigned int quad_index_buffer(int quads);
+
 } // namespace flux
\ No newline at end of file
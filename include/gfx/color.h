@@ -46,4 +46,37 @@ struct color
     color operator/(double s) const;
 };
 
+// color in single precision, as vertex data holds it. see #vec2f.
+struct colorf
+{
+    float r = 1.0f;
+    float g = 1.0f;
+    float b = 1.0f;
+    float a = 1.0f;
+
+    colorf() = default;
+    colorf(float x, float y, float z, float w = 1.0f) : r(x), g(y), b(z), a(w)
+    {
+    }
+    explicit colorf(const color &c) : r(float(c.r)), g(float(c.g)), b(float(c.b)), a(float(c.a))
+    {
+    }
+
+    operator color() const
+    {
+        return color(r, g, b, a);
+    }
+
+    colorf operator*(const colorf &v) const
+    {
+        return colorf(r * v.r, g * v.g, b * v.b, a * v.a);
+    }
+
+    // like color, it does not touch alpha.
+    colorf operator*(float s) const
+    {
+        return colorf(r * s, g * s, b * s, a);
+    }
+};
+
 } // namespace flux::gfx
\ No newline at end of file
@@ -15,7 +15,9 @@ struct mesh
     shared<complex_buffer> buffer;
     shared<brush> brush_binded;
 
-    /* unstable */ unsigned int __vao, __vbo, __ebo;
+    /* unstable */ unsigned int __vao, __vbo;
+    // whether quad_index_buffer is bound to #__vao yet.
+    /* unstable */ bool __quad_ibo_bound = false;
     /* unstable */ bool __is_direct;
 
     mesh();
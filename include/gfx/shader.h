@@ -26,6 +26,25 @@ struct shader_attrib
     void layout(shader_vertex_data_type size, int components, int stride, int offset, bool normalize = false);
 };
 
+// one attribute of a vertex format, at the byte #offset of each vertex.
+struct vertex_attrib
+{
+    shader_vertex_data_type type = FX_VDAT_FLOAT;
+    int components = 0;
+    int offset = 0;
+    bool normalize = false;
+};
+
+// the layout of a vertex struct (see gfx/vertex.h). attribs are bound to locations 0, 1, 2, ... in order.
+struct vertex_format
+{
+    static constexpr int MAX_ATTRIBS = 8;
+
+    int stride = 0;
+    int count = 0;
+    vertex_attrib attribs[MAX_ATTRIBS]{};
+};
+
 struct shader_uniform
 {
     unsigned int __uniform_id = 0;
@@ -52,6 +71,8 @@ struct shader_program
     ~shader_program();
     shader_attrib get_attrib(const std::string &name);
     shader_attrib get_attrib(int index);
+    // layout all attribs of #fmt, i.e. get_attrib(i).layout(...) for each of them.
+    void layout(const vertex_format &fmt);
     shader_uniform get_uniform(const std::string &name);
     shader_uniform cache_uniform(const std::string &name);
 };
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <gfx/color.h>
+#include <gfx/shader.h>
+
+namespace flux::gfx
+{
+
+// a 16-bit float, as stored in vertex data.
+using half = uint16_t;
+
+// rounds to nearest even, like the gpu does. values out of range become infinity, tiny ones denormals.
+half to_half(float f);
+// #to_half on #n values, with f16c (or sse2) where the cpu has it.
+void to_half_many(const float *in, half *out, int n);
+
+// vertex structs are written into complex_buffer as they are, and each one declares its #format,
+// which the shader setup lays out with shader_program::layout. so a layout is only written down here.
+
+// the vertex of FX_COLORED_* modes.
+struct vertex_colored
+{
+    float x, y;
+    half r, g, b, a;
+
+    static const vertex_format format;
+};
+
+inline constexpr vertex_format vertex_colored::format = {
+    sizeof(vertex_colored),
+    2,
+    {
+        {FX_VDAT_FLOAT, 2, offsetof(vertex_colored, x)},
+        {FX_VDAT_HALF_FLOAT, 4, offsetof(vertex_colored, r)},
+    },
+};
+
+// the vertex of FX_TEXTURED_QUAD mode.
+struct vertex_textured
+{
+    float x, y;
+    half r, g, b, a;
+    float u, v;
+
+    static const vertex_format format;
+};
+
+inline constexpr vertex_format vertex_textured::format = {
+    sizeof(vertex_textured),
+    3,
+    {
+        {FX_VDAT_FLOAT, 2, offsetof(vertex_textured, x)},
+        {FX_VDAT_HALF_FLOAT, 4, offsetof(vertex_textured, r)},
+        {FX_VDAT_FLOAT, 2, offsetof(vertex_textured, u)},
+    },
+};
+
+static_assert(sizeof(vertex_colored) == 16 && sizeof(vertex_textured) == 24, "vertex structs must not be padded.");
+
+} // namespace flux::gfx
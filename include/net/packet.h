@@ -4,6 +4,7 @@
 #include <core/uuid.h>
 #include <core/registry.h>
 #include <functional>
+#include <map>
 #include <core/registry.h>
 
 #define FX_USE_BUILTIN_PACKETS
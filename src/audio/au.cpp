@@ -109,7 +109,7 @@ void tk_end_make_device()
     // nothing
 }
 
-shared<track> load_track(const hio_path &path)
+shared<wave> load_wave(const hio_path &path)
 {
     auto file = hio_read_bytes(path);
 
@@ -126,14 +126,7 @@ shared<track> load_track(const hio_path &path)
     if (file[index++] != 'W' || file[index++] != 'A' || file[index++] != 'V' || file[index++] != 'E')
         prtlog_throw(FX_FATAL, "not a wave file: {}", path.absolute);
 
-    int samp_rate = 0;
-    int16_t bps = 0;
-    int16_t n_ch = 0;
-    int byte_size = 0;
-    ALenum format = 0;
-
-    ALuint buffer;
-    alGenBuffers(1, &buffer);
+    auto wav = std::make_shared<wave>();
 
     while (index + 8 <= file.size())
     {
@@ -159,41 +152,18 @@ shared<track> load_track(const hio_path &path)
             if (audio_format != 1)
                 prtlog_throw(FX_FATAL, "unknown format: {}", path.absolute);
 
-            n_ch = *reinterpret_cast<const int16_t *>(&file[index]);
+            wav->channels = *reinterpret_cast<const int16_t *>(&file[index]);
             index += 2;
-            samp_rate = *reinterpret_cast<const int32_t *>(&file[index]);
+            wav->samp_rate = *reinterpret_cast<const int32_t *>(&file[index]);
             index += 4;
             index += 4;
             index += 2;
-            bps = *reinterpret_cast<const int16_t *>(&file[index]);
+            wav->bps = *reinterpret_cast<const int16_t *>(&file[index]);
             index += 2;
-
-            if (n_ch == 1)
-            {
-                if (bps == 8)
-                    format = AL_FORMAT_MONO8;
-                else if (bps == 16)
-                    format = AL_FORMAT_MONO16;
-                else
-                    prtlog_throw(FX_FATAL, "can't play mono " + std::to_string(bps) + " sound.");
-            }
-            else if (n_ch == 2)
-            {
-                if (bps == 8)
-                    format = AL_FORMAT_STEREO8;
-                else if (bps == 16)
-                    format = AL_FORMAT_STEREO16;
-                else
-                    prtlog_throw(FX_FATAL, "can't play stereo " + std::to_string(bps) + " sound.");
-            }
-            else
-                prtlog_throw(FX_FATAL, "can't play audio with " + std::to_string(n_ch) + " channels");
         }
         else if (identifier == "data")
         {
-            byte_size = chunk_size;
-            const byte *data = &file[index];
-            alBufferData(buffer, format, data, chunk_size, samp_rate);
+            wav->pcm.assign(file.begin() + index, file.begin() + index + chunk_size);
             index += chunk_size;
         }
         else if (identifier == "JUNK" || identifier == "iXML")
@@ -202,13 +172,52 @@ shared<track> load_track(const hio_path &path)
             index += chunk_size;
     }
 
+    return wav;
+}
+
+shared<track> make_track(shared<wave> wav)
+{
+    int n_ch = wav->channels;
+    int bps = wav->bps;
+    ALenum format = 0;
+
+    if (n_ch == 1)
+    {
+        if (bps == 8)
+            format = AL_FORMAT_MONO8;
+        else if (bps == 16)
+            format = AL_FORMAT_MONO16;
+        else
+            prtlog_throw(FX_FATAL, "can't play mono " + std::to_string(bps) + " sound.");
+    }
+    else if (n_ch == 2)
+    {
+        if (bps == 8)
+            format = AL_FORMAT_STEREO8;
+        else if (bps == 16)
+            format = AL_FORMAT_STEREO16;
+        else
+            prtlog_throw(FX_FATAL, "can't play stereo " + std::to_string(bps) + " sound.");
+    }
+    else
+        prtlog_throw(FX_FATAL, "can't play audio with " + std::to_string(n_ch) + " channels");
+
+    ALuint buffer;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, format, wav->pcm.data(), wav->pcm.size(), wav->samp_rate);
+
     auto ptr = std::make_shared<track>();
     ptr->__track_id = buffer;
-    ptr->sec_len = (double)byte_size / (samp_rate * bps / 8.0) / n_ch;
+    ptr->sec_len = (double)wav->pcm.size() / (wav->samp_rate * bps / 8.0) / n_ch;
 
     return ptr;
 }
 
+shared<track> load_track(const hio_path &path)
+{
+    return make_track(load_wave(path));
+}
+
 shared<clip> make_clip(shared<track> track)
 {
     unsigned int id;
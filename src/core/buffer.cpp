@@ -21,6 +21,12 @@ byte_buf::byte_buf(const std::vector<byte> &vec)
     __wpos = vec.size();
 }
 
+byte_buf::byte_buf(std::vector<byte> &&vec)
+{
+    __wpos = vec.size();
+    __data = std::move(vec);
+}
+
 size_t byte_buf::size() const
 {
     return __wpos;
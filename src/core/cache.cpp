@@ -0,0 +1,125 @@
+#include <core/cache.h>
+#include <core/log.h>
+#include <fmt/format.h>
+
+namespace flux
+{
+
+static const int CACHE_MAGIC = 0x43415846; // FXAC
+static const int CACHE_VERSION = 1;
+
+// fnv-1a, stable across runs and platforms, unlike std::hash.
+static uint64_t __fnv1a(const byte *data, size_t len)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t __hash_file(const hio_path &src)
+{
+    auto raw = hio_read_bytes(src);
+    return __fnv1a(raw.data(), raw.size());
+}
+
+hio_path asset_cache::__entry(const hio_path &src) const
+{
+    uint64_t h = __fnv1a(reinterpret_cast<const byte *>(src.absolute.data()), src.absolute.size());
+    return dir / fmt::format("{:016x}.fxc", h);
+}
+
+// header: magic, version, mtime, content hash, compressed flag, then the payload.
+static void __write_entry(const hio_path &entry, long long mtime, uint64_t chash, bool comp,
+                          const std::vector<byte> &payload)
+{
+    byte_buf buf;
+    buf.write<int>(CACHE_MAGIC);
+    buf.write<int>(CACHE_VERSION);
+    buf.write<long long>(mtime);
+    buf.write<uint64_t>(chash);
+    buf.write<byte>(comp ? 1 : 0);
+    buf.write_bytes(payload.data(), payload.size());
+
+    // write aside and rename, so a crash never leaves a torn entry behind.
+    hio_path tmp = hio_path(entry.absolute + ".tmp");
+    hio_write_bytes(tmp, buf.to_vector());
+    hio_rename(tmp, entry.absolute);
+}
+
+static const size_t CACHE_HEADER = 25;
+
+bool asset_cache::fetch(const hio_path &src, byte_buf &out, cache_stamp *stamp)
+{
+    cache_stamp st;
+    st.mtime = hio_mtime(src);
+    if (stamp != nullptr)
+        *stamp = st;
+
+    hio_path entry = __entry(src);
+    if (!hio_exists(entry))
+        return false;
+
+    // a torn or foreign entry is just a miss. it is overwritten by the next #store.
+    try
+    {
+        byte_buf buf = byte_buf(hio_read_bytes(entry));
+        if (buf.readable_bytes() < CACHE_HEADER || buf.read<int>() != CACHE_MAGIC ||
+            buf.read<int>() != CACHE_VERSION)
+            return false;
+        long long mtime = buf.read<long long>();
+        uint64_t chash = buf.read<uint64_t>();
+        bool comp = buf.read<byte>() != 0;
+
+        if (mtime != st.mtime)
+        {
+            // touched, but maybe not changed (like a fresh checkout). only the content decides.
+            st.chash = __hash_file(src);
+            st.hashed = true;
+            if (stamp != nullptr)
+                *stamp = st;
+            if (st.chash != chash)
+                return false;
+            // patch the mtime in place and write the entry back as it is.
+            long long m = buf.to_native_endian(st.mtime);
+            std::memcpy(buf.__data.data() + 8, &m, sizeof(m));
+            hio_path tmp = hio_path(entry.absolute + ".tmp");
+            hio_write_bytes(tmp, buf.__data);
+            hio_rename(tmp, entry.absolute);
+        }
+
+        if (comp)
+            out = byte_buf(hio_decompress(buf.read_advance((int)buf.readable_bytes())));
+        else
+            out = std::move(buf);
+        return true;
+    }
+    catch (std::exception &)
+    {
+        return false;
+    }
+}
+
+void asset_cache::store(const hio_path &src, const byte_buf &blob, const cache_stamp *stamp)
+{
+    bool comp = clvl != FX_COMP_NO;
+    std::vector<byte> payload = blob.to_vector();
+    if (comp)
+        payload = hio_compress(payload, clvl);
+    long long mtime = stamp != nullptr ? stamp->mtime : hio_mtime(src);
+    uint64_t chash = stamp != nullptr && stamp->hashed ? stamp->chash : __hash_file(src);
+    __write_entry(__entry(src), mtime, chash, comp, payload);
+}
+
+shared<asset_cache> make_asset_cache(const hio_path &dir, compression_level clvl)
+{
+    auto ptr = std::make_shared<asset_cache>();
+    ptr->dir = dir;
+    ptr->clvl = clvl;
+    return ptr;
+}
+
+} // namespace flux
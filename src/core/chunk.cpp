@@ -0,0 +1,229 @@
+#include <core/chunk.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace flux
+{
+
+// what a chunk is generated with, taken when it is requested.
+struct __chunk_conf
+{
+    long seed;
+    int size;
+    double scale;
+    std::vector<shared<noise>> layers;
+    std::vector<chunk_stage> stages;
+};
+
+struct __chunk_entry
+{
+    int cx, cy;
+    // a chunk cancelled & requested again gets a new ticket, so a stale run can tell it is dropped.
+    uint64_t ticket;
+    shared<__chunk_conf> conf;
+};
+
+static uint64_t __chunk_key(int cx, int cy)
+{
+    return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+}
+
+struct chunk_gen::_impl
+{
+    std::mutex mtx;
+    // chunks not started yet. the nearest one is searched linearly when a worker is free:
+    // the focus moves every tick, so a heap would have to be rebuilt anyway.
+    std::vector<__chunk_entry> queued;
+    // the ticket of every chunk requested and not delivered (or cancelled) yet.
+    std::unordered_map<uint64_t, uint64_t> tickets;
+    std::vector<std::pair<uint64_t, shared<chunk>>> done;
+    uint64_t __ticket_next = 1;
+    double fx = 0, fy = 0;
+
+    bool __alive(const __chunk_entry &e)
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto it = tickets.find(__chunk_key(e.cx, e.cy));
+        return it != tickets.end() && it->second == e.ticket;
+    }
+
+    // run by a worker. it takes the queued chunk nearest to the focus, whichever was requested for this job.
+    void __run_one()
+    {
+        __chunk_entry e;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (queued.empty())
+                return;
+
+            size_t best = 0;
+            double best_d = INFINITY;
+            for (size_t i = 0; i < queued.size(); i++)
+            {
+                const __chunk_entry &q = queued[i];
+                double span = q.conf->size * q.conf->scale;
+                double dx = (q.cx + 0.5) * span - fx;
+                double dy = (q.cy + 0.5) * span - fy;
+                double d = dx * dx + dy * dy;
+                if (d < best_d)
+                {
+                    best_d = d;
+                    best = i;
+                }
+            }
+            e = std::move(queued[best]);
+            queued[best] = std::move(queued.back());
+            queued.pop_back();
+        }
+
+        // a throwing layer or stage must not take the worker down. the chunk is dropped, so it leaves #pending.
+        shared<chunk> c;
+        try
+        {
+            c = __generate(e);
+        }
+        catch (std::exception &ex)
+        {
+            prtlog(FX_WARN, "chunk ({}, {}) failed: {}", e.cx, e.cy, ex.what());
+        }
+
+        std::lock_guard<std::mutex> lk(mtx);
+        auto it = tickets.find(__chunk_key(e.cx, e.cy));
+        if (it == tickets.end() || it->second != e.ticket)
+            return;
+        if (c != nullptr)
+            done.push_back({e.ticket, c});
+        else
+            tickets.erase(it);
+    }
+
+    // sample the layers & run the stages. returns null if the chunk is dropped in between.
+    shared<chunk> __generate(const __chunk_entry &e)
+    {
+        const __chunk_conf &cf = *e.conf;
+        auto c = std::make_shared<chunk>();
+        c->cx = e.cx;
+        c->cy = e.cy;
+        c->size = cf.size;
+        c->layers.resize(cf.layers.size());
+
+        double span = cf.size * cf.scale;
+        for (size_t l = 0; l < cf.layers.size(); l++)
+        {
+            c->layers[l].resize((size_t)cf.size * cf.size);
+            cf.layers[l]->generate_grid(vec3(e.cx * span, e.cy * span, 0), vec3(cf.scale, cf.scale, 1), cf.size,
+                                        cf.size, 1, c->layers[l].data());
+        }
+
+        // each worker keeps one generator, reseeded per chunk. the stream then only depends on the chunk.
+        thread_local random rd;
+        rd.set_seed_bits((uint64_t)cf.seed ^ ((uint64_t)(uint32_t)e.cx * 0x9E3779B97F4A7C15ULL) ^
+                         ((uint64_t)(uint32_t)e.cy * 0xC2B2AE3D27D4EB4FULL));
+        for (auto &stage : cf.stages)
+        {
+            if (!__alive(e))
+                return nullptr;
+            stage(*c, rd);
+        }
+        return c;
+    }
+};
+
+// for shared_ptr<_impl> to refer
+chunk_gen::chunk_gen() : __p(std::make_shared<_impl>()), pool(get_gpool())
+{
+}
+
+chunk_gen::~chunk_gen()
+{
+    // jobs still in the pool find nothing queued, and return.
+    cancel_all();
+}
+
+void chunk_gen::request(int cx, int cy)
+{
+    uint64_t key = __chunk_key(cx, cy);
+    {
+        std::lock_guard<std::mutex> lk(__p->mtx);
+        if (__p->tickets.count(key))
+            return;
+        uint64_t ticket = __p->__ticket_next++;
+        __p->tickets[key] = ticket;
+        auto conf = std::make_shared<__chunk_conf>(__chunk_conf{seed, size, scale, layers, stages});
+        __p->queued.push_back({cx, cy, ticket, conf});
+    }
+
+    shared<_impl> p = __p;
+    pool->submit([p]() { p->__run_one(); });
+}
+
+void chunk_gen::cancel(int cx, int cy)
+{
+    uint64_t key = __chunk_key(cx, cy);
+    std::lock_guard<std::mutex> lk(__p->mtx);
+    auto it = __p->tickets.find(key);
+    if (it == __p->tickets.end())
+        return;
+    uint64_t ticket = it->second;
+    __p->tickets.erase(it);
+
+    auto &q = __p->queued;
+    q.erase(std::remove_if(q.begin(), q.end(), [&](const __chunk_entry &e) { return e.ticket == ticket; }), q.end());
+    auto &d = __p->done;
+    d.erase(std::remove_if(d.begin(), d.end(), [&](auto &e) { return e.first == ticket; }), d.end());
+}
+
+void chunk_gen::cancel_all()
+{
+    std::lock_guard<std::mutex> lk(__p->mtx);
+    __p->tickets.clear();
+    __p->queued.clear();
+    __p->done.clear();
+}
+
+void chunk_gen::focus(const vec2 &pos)
+{
+    std::lock_guard<std::mutex> lk(__p->mtx);
+    __p->fx = pos.x;
+    __p->fy = pos.y;
+}
+
+void chunk_gen::poll(int max)
+{
+    std::vector<shared<chunk>> out;
+    {
+        std::lock_guard<std::mutex> lk(__p->mtx);
+        int n = std::min(max, (int)__p->done.size());
+        for (int i = 0; i < n; i++)
+        {
+            auto &[ticket, c] = __p->done[i];
+            __p->tickets.erase(__chunk_key(c->cx, c->cy));
+            out.push_back(std::move(c));
+        }
+        __p->done.erase(__p->done.begin(), __p->done.begin() + n);
+    }
+
+    // called outside the lock, so the callback can request more chunks.
+    if (event_on_chunk)
+        for (auto &c : out)
+            event_on_chunk(c);
+}
+
+int chunk_gen::pending() const
+{
+    std::lock_guard<std::mutex> lk(__p->mtx);
+    return (int)__p->tickets.size();
+}
+
+shared<chunk_gen> make_chunk_gen(long seed, int size, double scale)
+{
+    auto ptr = std::make_shared<chunk_gen>();
+    ptr->seed = seed;
+    ptr->size = size;
+    ptr->scale = scale;
+    return ptr;
+}
+
+} // namespace flux
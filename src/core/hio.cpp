@@ -91,6 +91,11 @@ hpath_type hio_judge(const hio_path &path)
     return FX_UNKNOWN;
 }
 
+long long hio_mtime(const hio_path &path)
+{
+    return fs::last_write_time(path.__npath).time_since_epoch().count();
+}
+
 std::vector<hio_path> hio_sub_dirs(const hio_path &path)
 {
     std::vector<hio_path> paths;
@@ -165,8 +170,12 @@ static std::vector<byte> brotli_decompress(const std::vector<byte> &src)
             dst.insert(dst.end(), buf, buf + produced);
         if (rc == BROTLI_DECODER_RESULT_SUCCESS)
             break;
-        if (rc == BROTLI_DECODER_RESULT_ERROR)
+        // a truncated stream asks for more input forever.
+        if (rc == BROTLI_DECODER_RESULT_ERROR || (rc == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT && avail_in == 0))
+        {
+            BrotliDecoderDestroyInstance(st);
             prtlog_throw(FX_FATAL, "brotli decoder error");
+        }
     }
     BrotliDecoderDestroyInstance(st);
     return dst;
@@ -1,8 +1,79 @@
 #include <core/id.h>
+#include <core/log.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace flux
 {
 
+static constexpr int INTERN_CHUNK_BITS = 12;
+static constexpr int INTERN_CHUNK_SIZE = 1 << INTERN_CHUNK_BITS;
+static constexpr int INTERN_MAX_CHUNKS = 4096;
+
+// strings are kept in fixed chunks that never move, so #interned reads without locking.
+// the index views the chunk strings, which is fine since they never move either.
+struct __interner
+{
+    std::atomic<std::string *> chunks[INTERN_MAX_CHUNKS]{};
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::shared_mutex mtx;
+    uint32_t next = 0;
+
+    __interner()
+    {
+        // handle 0 is the empty string, so default ids need no lookup.
+        intern_locked("");
+    }
+
+    uint32_t intern_locked(std::string_view str)
+    {
+        uint32_t h = next++;
+        if ((h >> INTERN_CHUNK_BITS) >= INTERN_MAX_CHUNKS)
+            prtlog_throw(FX_FATAL, "too many interned strings.");
+        if ((h & (INTERN_CHUNK_SIZE - 1)) == 0)
+            chunks[h >> INTERN_CHUNK_BITS].store(new std::string[INTERN_CHUNK_SIZE], std::memory_order_release);
+        std::string &slot = at(h);
+        slot = std::string(str);
+        index[slot] = h;
+        return h;
+    }
+
+    std::string &at(uint32_t h)
+    {
+        return chunks[h >> INTERN_CHUNK_BITS].load(std::memory_order_acquire)[h & (INTERN_CHUNK_SIZE - 1)];
+    }
+};
+
+static __interner &__get_interner()
+{
+    static __interner itn;
+    return itn;
+}
+
+uint32_t intern(std::string_view str)
+{
+    auto &itn = __get_interner();
+    {
+        std::shared_lock<std::shared_mutex> lk(itn.mtx);
+        auto it = itn.index.find(str);
+        if (it != itn.index.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lk(itn.mtx);
+    auto it = itn.index.find(str);
+    if (it != itn.index.end())
+        return it->second;
+    return itn.intern_locked(str);
+}
+
+const std::string &interned(uint32_t handle)
+{
+    return __get_interner().at(handle);
+}
+
 res_scope::res_scope() = default;
 
 res_scope::res_scope(const std::string &key) : key(key)
@@ -13,40 +84,44 @@ res_id::res_id() = default;
 
 res_id::res_id(const std::string &cat)
 {
-    concat = cat;
+    __handle = intern(cat);
     auto pos = cat.find_last_of(':');
-    key = cat.substr(pos + 1);
-    scope = cat.substr(0, pos);
-    __hash = std::hash<std::string>{}(concat);
+    __split = pos == std::string::npos ? UINT32_MAX : (uint32_t)pos;
 }
 
-res_id::res_id(const res_scope &sc, const std::string &k)
+res_id::res_id(const res_scope &sc, const std::string &k) : res_id(sc.key + ":" + k)
 {
-    scope = sc;
-    key = k;
-    concat = scope.key + ":" + key;
-    __hash = std::hash<std::string>{}(concat);
+    // the key may have colons of its own, the split is where the scope ends.
+    __split = (uint32_t)sc.key.size();
 }
 
 res_id::res_id(const char ch_arr[]) : res_id(std::string(ch_arr))
 {
 }
 
-res_id::operator std::string() const
+const std::string &res_id::concat() const
 {
-    return concat;
+    return interned(__handle);
 }
 
-bool res_id::operator==(const res_id &other) const
+std::string res_id::scope() const
 {
-    if (other.__hash != __hash)
-        return false;
-    return other.concat == concat;
+    // with no colon, both the scope & the key are the whole string.
+    if (__split == UINT32_MAX)
+        return concat();
+    return concat().substr(0, __split);
 }
 
-bool res_id::operator<(const res_id &other) const
+std::string res_id::key() const
+{
+    if (__split == UINT32_MAX)
+        return concat();
+    return concat().substr(__split + 1);
+}
+
+res_id::operator std::string() const
 {
-    return other.concat < concat;
+    return concat();
 }
 
 } // namespace flux
@@ -1,7 +1,16 @@
 #include <core/load.h>
 #include <gfx/image.h>
 #include <gfx/font.h>
+#include <gfx/atlas.h>
 #include <audio/au.h>
+#include <algorithm>
+#include <condition_variable>
+#include <core/bio.h>
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
 
 using namespace flux::gfx;
 using namespace flux::au;
@@ -9,13 +18,107 @@ using namespace flux::au;
 namespace flux
 {
 
-std::unordered_map<res_id, std::any> __resource_map;
+// first stages of the finished tasks, to load the resources again after eviction.
+static std::unordered_map<res_id, std::function<proc_finalizer()>> __reloaders;
+static std::mutex __reloaders_mtx;
 
-std::unordered_map<res_id, std::any> *__get_resource_map()
+bool __can_reload(const res_id &id)
 {
-    return &__resource_map;
+    std::lock_guard<std::mutex> lk(__reloaders_mtx);
+    return __reloaders.find(id) != __reloaders.end();
 }
 
+// for resources published later than their task, by something a reload cannot redo.
+static void __drop_reloader(const res_id &id)
+{
+    std::lock_guard<std::mutex> lk(__reloaders_mtx);
+    __reloaders.erase(id);
+}
+
+static std::vector<res_id> __trace;
+static std::unordered_set<res_id> __trace_seen;
+static int __trace_urgent = 0;
+static std::mutex __trace_mtx;
+static std::atomic<bool> __tracing = false;
+
+void __trace_res(const res_id &id)
+{
+    if (!__tracing.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lk(__trace_mtx);
+    if (__trace_seen.insert(id).second)
+        __trace.push_back(id);
+}
+
+void res_trace_begin()
+{
+    std::lock_guard<std::mutex> lk(__trace_mtx);
+    __trace.clear();
+    __trace_seen.clear();
+    __trace_urgent = 0;
+    __tracing = true;
+}
+
+void res_trace_mark_urgent()
+{
+    std::lock_guard<std::mutex> lk(__trace_mtx);
+    __trace_urgent = (int)__trace.size();
+}
+
+void res_trace_end(const hio_path &manifest)
+{
+    std::lock_guard<std::mutex> lk(__trace_mtx);
+    __tracing = false;
+
+    binary_array ids;
+    for (auto &id : __trace)
+        ids.push(std::string(id));
+    binary_map map;
+    map.set("ids", ids);
+    map.set("urgent", __trace_urgent);
+    bio_write(map, manifest);
+}
+
+bool __reload(const res_id &id)
+{
+    std::function<proc_finalizer()> fn;
+    {
+        std::lock_guard<std::mutex> lk(__reloaders_mtx);
+        auto it = __reloaders.find(id);
+        if (it == __reloaders.end())
+            return false;
+        fn = it->second;
+    }
+
+    proc_finalizer fin = fn();
+    if (fin)
+        fin();
+    return true;
+}
+
+struct asset_loader::_impl
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    // second stages whose first stage is done, waiting for #next.
+    // urgent ones (see #res_trace_mark_urgent) are finalized first.
+    std::deque<std::function<void()>> ready;
+    std::deque<std::function<void()>> ready_urgent;
+    // tasks dispatched, but not finalized yet.
+    int pending = 0;
+    // urgent tasks dispatched, but not finalized yet. only touched on the thread calling #next.
+    int urgent_pending = 0;
+    bool dispatched = false;
+};
+
+// for shared_ptr<_impl> to refer
+asset_loader::asset_loader() : pool(get_gpool()), __p(std::make_shared<_impl>())
+{
+}
+
+// for shared_ptr<_impl> to refer
+asset_loader::~asset_loader() = default;
+
 void asset_loader::scan(const hio_path &path_root)
 {
     for (const hio_path &path : hio_recurse_files(path_root))
@@ -28,7 +131,7 @@ void asset_loader::scan(const hio_path &path_root)
             if (process_strategy_map.find(fmt) != process_strategy_map.end())
             {
                 proc_strategy sttg = process_strategy_map[fmt];
-                tasks.push([sttg, path, id]() { sttg(path, id); });
+                tasks.push({id, [sttg, path, id]() { return sttg(path, id); }});
                 __total_tcount++;
             }
         }
@@ -38,51 +141,321 @@ void asset_loader::scan(const hio_path &path_root)
 void asset_loader::add_sub(shared<asset_loader> subloader)
 {
     subloaders.push_back(subloader);
-    __total_tcount += subloader->__total_tcount;
 }
 
-void asset_loader::next()
+void asset_loader::__collect(std::vector<std::pair<asset_loader *, asset_task>> &out)
 {
-    if (__end_called)
-        return;
-
-    if (!__start_called && event_on_start)
+    if (!__start_called)
     {
-        event_on_start();
+        if (event_on_start)
+            event_on_start();
         __start_called = true;
     }
 
-    if (!tasks.empty())
+    while (!tasks.empty())
     {
-        auto fn = tasks.top();
+        out.push_back({this, tasks.top()});
         tasks.pop();
+    }
+
+    for (auto sub : subloaders)
+        sub->__collect(out);
+}
+
+void asset_loader::__dispatch()
+{
+    std::vector<std::pair<asset_loader *, asset_task>> batch;
+    __collect(batch);
+
+    auto rank_of = [this](const res_id &id) {
+        auto it = __rank.find(id);
+        return it == __rank.end() ? INT_MAX : it->second;
+    };
+    if (!__rank.empty())
+        std::stable_sort(batch.begin(), batch.end(),
+                         [&](const auto &a, const auto &b) { return rank_of(a.second.id) < rank_of(b.second.id); });
+
+    shared<_impl> sink = __p;
+    sink->dispatched = true;
+    for (auto &[owner, task] : batch)
+    {
+        bool urgent = rank_of(task.id) < __urgent_rank;
+        {
+            std::lock_guard<std::mutex> lk(sink->mtx);
+            sink->pending++;
+        }
+        if (urgent)
+            sink->urgent_pending++;
+
+        // the loaders themselves are only touched by the second stage, which runs in #next of the root.
+        owner->pool->submit([owner, sink, task, urgent]() {
+            using clock = std::chrono::steady_clock;
+            auto t0 = clock::now();
+            proc_finalizer fin;
+            try
+            {
+                fin = task.fn();
+            }
+            catch (...)
+            {
+                // re-throw on the main thread, as if the task ran there.
+                auto e = std::current_exception();
+                fin = [e]() { std::rethrow_exception(e); };
+            }
+            auto decode = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - t0);
+
+            std::lock_guard<std::mutex> lk(sink->mtx);
+            auto &queue = urgent ? sink->ready_urgent : sink->ready;
+            // the queue belongs to the sink, so a raw pointer outlives the entry, without a reference cycle.
+            _impl *sp = sink.get();
+            queue.push_back([owner, sp, fin, decode, task, urgent]() {
+                auto t1 = clock::now();
+                {
+                    std::lock_guard<std::mutex> lk(__reloaders_mtx);
+                    __reloaders[task.id] = task.fn;
+                }
+                if (fin)
+                    fin();
+                if (urgent)
+                    sp->urgent_pending--;
+                owner->__done_tcount++;
+                if (owner->event_on_task)
+                    owner->event_on_task(task.id, decode,
+                                         std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - t1));
+            });
+            sink->cv.notify_one();
+        });
+    }
+}
+
+void asset_loader::order_by(const hio_path &manifest)
+{
+    if (!hio_exists(manifest))
+        return;
+
+    binary_map map = bio_read(manifest);
+    binary_array ids = map.get<binary_array>("ids");
+    int urgent = map.get<int>("urgent");
+
+    // ids are dispatched in recorded order, so urgent ones (the first #urgent) go first, and unknown ids go last.
+    __rank.clear();
+    for (int i = 0; i < (int)ids.size(); i++)
+        __rank[res_id(ids.get<std::string>(i))] = i;
+    __urgent_rank = urgent;
+}
+
+bool asset_loader::urgent_done() const
+{
+    return __p->dispatched && __p->urgent_pending == 0;
+}
+
+int asset_loader::__count_done() const
+{
+    int n = __done_tcount;
+    for (auto sub : subloaders)
+        n += sub->__count_done();
+    return n;
+}
+
+int asset_loader::__count_total() const
+{
+    int n = __total_tcount;
+    for (auto sub : subloaders)
+        n += sub->__count_total();
+    return n;
+}
+
+void asset_loader::__refresh()
+{
+    for (auto sub : subloaders)
+        sub->__refresh();
+
+    int total = __count_total();
+    progress = total == 0 ? 1 : double(__count_done()) / double(total);
+
+    if (progress >= 1 && !__end_called)
+    {
+        for (auto &fin : __finishers)
+            fin();
+        if (event_on_end)
+            event_on_end();
+        __end_called = true;
+    }
+}
+
+bool asset_loader::__step(const std::chrono::steady_clock::time_point *deadline)
+{
+    if (__end_called)
+        return false;
+
+    // also picks up tasks scanned after the first call.
+    __dispatch();
+
+    std::function<void()> fn;
+    {
+        std::unique_lock<std::mutex> lk(__p->mtx);
+        auto can_go = [this]() { return !__p->ready_urgent.empty() || !__p->ready.empty() || __p->pending == 0; };
+        if (deadline == nullptr)
+            __p->cv.wait(lk, can_go);
+        else
+            __p->cv.wait_until(lk, *deadline, can_go);
+        auto &queue = !__p->ready_urgent.empty() ? __p->ready_urgent : __p->ready;
+        if (!queue.empty())
+        {
+            fn = std::move(queue.front());
+            queue.pop_front();
+            __p->pending--;
+        }
+    }
+
+    if (fn)
         fn();
-        __done_tcount++;
-        progress = double(__done_tcount) / double(__total_tcount);
+    __refresh();
+    return fn != nullptr;
+}
+
+void asset_loader::next()
+{
+    __step(nullptr);
+}
+
+void asset_loader::next_for(std::chrono::microseconds budget)
+{
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    while (__step(&deadline) && std::chrono::steady_clock::now() < deadline)
+        ;
+}
+
+// a cache that cannot be written (read-only, full) only costs the warm start, the asset itself is fine.
+static void __store_cached(asset_cache &cache, const hio_path &path, const byte_buf &blob, const cache_stamp &stamp)
+{
+    try
+    {
+        cache.store(path, blob, &stamp);
     }
-    else
+    catch (std::exception &e)
     {
-        progress = 1;
+        prtlog(FX_WARN, "cannot cache {}: {}", path.absolute, e.what());
+    }
+}
+
+// decode a png, or fetch its pixels from the cache.
+static shared<image> __load_image_cached(shared<asset_cache> cache, const hio_path &path)
+{
+    if (cache == nullptr)
+        return load_image(path);
 
-        bool can_find = false;
-        for (auto sub : subloaders)
+    byte_buf blob;
+    cache_stamp stamp;
+    if (cache->fetch(path, blob, &stamp))
+    {
+        // a payload not matching its size is a bad entry, so decode the source over it.
+        size_t len = blob.readable_bytes();
+        if (len >= 8)
         {
-            if (sub->progress < 1)
+            int w = blob.read<int>();
+            int h = blob.read<int>();
+            if (w > 0 && h > 0 && len - 8 == (size_t)w * h * 4)
             {
-                sub->next();
-                can_find = true;
-                break;
+                byte *pixels = new byte[len - 8];
+                std::memcpy(pixels, blob.__data.data() + blob.read_pos(), len - 8);
+                return make_image(w, h, pixels);
             }
         }
-        if (!can_find)
+        blob = byte_buf();
+    }
+
+    auto img = load_image(path);
+    blob.write<int>(img->width);
+    blob.write<int>(img->height);
+    blob.write_bytes(img->pixels, img->width * img->height * 4);
+    __store_cached(*cache, path, blob, stamp);
+    return img;
+}
+
+// parse a wave, or fetch its pcm data from the cache.
+static shared<wave> __load_wave_cached(shared<asset_cache> cache, const hio_path &path)
+{
+    if (cache == nullptr)
+        return load_wave(path);
+
+    byte_buf blob;
+    cache_stamp stamp;
+    if (cache->fetch(path, blob, &stamp))
+    {
+        // only formats a wave can be played in, with whole frames of pcm. else it is a bad entry.
+        if (blob.readable_bytes() >= 12)
         {
-            if (!__end_called && event_on_end)
+            int samp_rate = blob.read<int>();
+            int bps = blob.read<int>();
+            int channels = blob.read<int>();
+            size_t frame = (size_t)channels * bps / 8;
+            if (samp_rate > 0 && (bps == 8 || bps == 16) && (channels == 1 || channels == 2) &&
+                blob.readable_bytes() % frame == 0)
             {
-                event_on_end();
-                __end_called = true;
+                auto wav = std::make_shared<wave>();
+                wav->samp_rate = samp_rate;
+                wav->bps = bps;
+                wav->channels = channels;
+                wav->pcm = blob.read_advance((int)blob.readable_bytes());
+                return wav;
             }
         }
+        blob = byte_buf();
+    }
+
+    auto wav = load_wave(path);
+    blob.write<int>(wav->samp_rate);
+    blob.write<int>(wav->bps);
+    blob.write<int>(wav->channels);
+    blob.write_bytes(wav->pcm.data(), wav->pcm.size());
+    __store_cached(*cache, path, blob, stamp);
+    return wav;
+}
+
+// upload the image and let the pixels go, so the gl texture is the only copy.
+static shared<texture> __upload_texture(shared<image> img)
+{
+    auto tex = make_texture(img);
+    tex->__relying_image = nullptr;
+    return tex;
+}
+
+// hard encoded warn: check later
+static const int ATLAS_PAGE_SIZE = 2048;
+static const int ATLAS_MAX_SIDE = 256;
+
+using __atlas_batch = std::vector<std::pair<res_id, shared<image>>>;
+
+// pack the images into as few pages as possible, and publish their regions.
+static void __pack_atlas(__atlas_batch &batch)
+{
+    // taller images first, so that the shelves of the free rects stay tight.
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const auto &a, const auto &b) { return a.second->height > b.second->height; });
+
+    shared<atlas> page = nullptr;
+    std::vector<shared<texture>> placed;
+    for (auto &[id, img] : batch)
+    {
+        shared<texture> tex = page == nullptr ? nullptr : page->try_accept(img);
+        if (tex == nullptr)
+        {
+            if (page != nullptr)
+                page->end();
+            page = make_atlas(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+            page->begin();
+            tex = page->accept(img);
+        }
+        put_res(id, tex);
+        placed.push_back(tex);
     }
+    if (page != nullptr)
+        page->end();
+
+    // the pages are uploaded, so the pixels are no longer needed.
+    for (auto &tex : placed)
+        tex->__relying_image = tex->root->__relying_image = nullptr;
 }
 
 shared<asset_loader> make_loader(const res_scope &scope, const hio_path &root)
@@ -95,37 +468,64 @@ shared<asset_loader> make_loader(const res_scope &scope, const hio_path &root)
 
 void make_loader_equipment(shared<asset_loader> loader, asset_loader_equip equipment)
 {
+    shared<asset_cache> cache = loader->cache;
+
     switch (equipment)
     {
     case FX_LOAD_PNG_AS_TEXTURE:
-        loader->process_strategy_map[".png"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(make_texture(load_image(path)));
+        loader->process_strategy_map[".png"] = [cache](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto img = __load_image_cached(cache, path);
+            return [img, id]() { put_res(id, __upload_texture(img), img->width * img->height * 4); };
+        };
+        break;
+    case FX_LOAD_PNG_AS_ATLAS: {
+        auto batch = std::make_shared<__atlas_batch>();
+        loader->process_strategy_map[".png"] = [cache, batch](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto img = __load_image_cached(cache, path);
+            if (img->width > ATLAS_MAX_SIDE || img->height > ATLAS_MAX_SIDE)
+                return [img, id]() { put_res(id, __upload_texture(img), img->width * img->height * 4); };
+            // packed entries are put with no cost, so never evicted. without a reloader, they are not
+            // reported done before #__pack_atlas puts them.
+            return [batch, img, id]() {
+                __drop_reloader(id);
+                batch->push_back({id, img});
+            };
         };
+        loader->__finishers.push_back([batch]() {
+            __pack_atlas(*batch);
+            batch->clear();
+        });
         break;
+    }
     case FX_LOAD_PNG_AS_IMAGE:
-        loader->process_strategy_map[".png"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(load_image(path));
+        loader->process_strategy_map[".png"] = [cache](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto img = __load_image_cached(cache, path);
+            return [img, id]() { put_res(id, img, img->width * img->height * 4); };
         };
         break;
     case FX_LOAD_TXT:
-        loader->process_strategy_map[".txt"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(hio_read_str(path));
+        loader->process_strategy_map[".txt"] = [](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto str = hio_read_str(path);
+            return [str, id]() { put_res(id, str, str.size()); };
         };
         break;
     case FX_LOAD_WAVE:
-        loader->process_strategy_map[".wav"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(load_track(path));
+        loader->process_strategy_map[".wav"] = [cache](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto wav = __load_wave_cached(cache, path);
+            return [wav, id]() { put_res(id, make_track(wav), wav->pcm.size()); };
         };
         break;
-    case FX_LOAD_FONT:
+    case FX_LOAD_FONT: {
+        // freetype states are per-font, so the whole font can be made on a worker.
         // hard encoded warn: check later
-        loader->process_strategy_map[".ttf"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(load_font(path, 12, 12));
-        };
-        loader->process_strategy_map[".otf"] = [](const hio_path &path, const res_id &id) {
-            __resource_map[id] = std::any(load_font(path, 12, 12));
+        proc_strategy sttg = [](const hio_path &path, const res_id &id) -> proc_finalizer {
+            auto fnt = load_font(path, 12, 12);
+            return [fnt, id]() { put_res(id, fnt); };
         };
+        loader->process_strategy_map[".ttf"] = sttg;
+        loader->process_strategy_map[".otf"] = sttg;
         break;
+    }
     case FX_LOAD_SCRIPT:
     case FX_LOAD_SHADER:
         break;
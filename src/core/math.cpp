@@ -1,4 +1,5 @@
 #include <core/math.h>
+#include <core/simd.h>
 #include "math.h"
 
 namespace flux
@@ -216,6 +217,67 @@ void transform::apply(vec2 &v) const
     v.y = m10 * xx + m11 * yy + m12;
 }
 
+#if defined(FX_X86)
+
+// 4 points per iteration. moveldup/movehdup spread x & y of each point over both of its lanes,
+// the coefficients are laid out as [m00 m10 m00 m10 ...] to match.
+FX_TARGET("avx2,fma") static int __apply_many_avx2(const transform &t, const float *in, float *out, int n)
+{
+    __m256 a = _mm256_setr_ps(t.m00, t.m10, t.m00, t.m10, t.m00, t.m10, t.m00, t.m10);
+    __m256 b = _mm256_setr_ps(t.m01, t.m11, t.m01, t.m11, t.m01, t.m11, t.m01, t.m11);
+    __m256 c = _mm256_setr_ps(t.m02, t.m12, t.m02, t.m12, t.m02, t.m12, t.m02, t.m12);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256 v = _mm256_loadu_ps(in + i * 2);
+        __m256 r = _mm256_fmadd_ps(_mm256_movehdup_ps(v), b, c);
+        _mm256_storeu_ps(out + i * 2, _mm256_fmadd_ps(_mm256_moveldup_ps(v), a, r));
+    }
+    return i;
+}
+
+#endif
+
+#if defined(FX_X86) && defined(__SSE2__)
+
+// 2 points per iteration.
+static int __apply_many_sse2(const transform &t, const float *in, float *out, int n)
+{
+    __m128 a = _mm_setr_ps(t.m00, t.m10, t.m00, t.m10);
+    __m128 b = _mm_setr_ps(t.m01, t.m11, t.m01, t.m11);
+    __m128 c = _mm_setr_ps(t.m02, t.m12, t.m02, t.m12);
+    int i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128 v = _mm_loadu_ps(in + i * 2);
+        __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+        _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, a), _mm_mul_ps(y, b)), c));
+    }
+    return i;
+}
+
+#endif
+
+void transform::apply_many(const float *xy_in, float *xy_out, int n) const
+{
+    int i = 0;
+#if defined(FX_X86)
+    if (cpu_has_avx2())
+        i = __apply_many_avx2(*this, xy_in, xy_out, n);
+#endif
+#if defined(FX_X86) && defined(__SSE2__)
+    if (i == 0)
+        i = __apply_many_sse2(*this, xy_in, xy_out, n);
+#endif
+    for (; i < n; i++)
+    {
+        float xx = xy_in[i * 2], yy = xy_in[i * 2 + 1];
+        xy_out[i * 2] = m00 * xx + m01 * yy + m02;
+        xy_out[i * 2 + 1] = m10 * xx + m11 * yy + m12;
+    }
+}
+
 transform &transform::translate(float tx, float ty)
 {
     m02 += m00 * tx + m01 * ty;
@@ -373,4 +435,142 @@ double quad::area() const
     return width * height;
 }
 
+int vec2_soa::size() const
+{
+    return (int)xs.size();
+}
+
+void vec2_soa::resize(int n)
+{
+    xs.resize(n);
+    ys.resize(n);
+}
+
+void vec2_soa::reserve(int n)
+{
+    xs.reserve(n);
+    ys.reserve(n);
+}
+
+void vec2_soa::clear()
+{
+    xs.clear();
+    ys.clear();
+}
+
+int vec2_soa::push(const vec2f &v)
+{
+    xs.push_back(v.x);
+    ys.push_back(v.y);
+    return (int)xs.size() - 1;
+}
+
+vec2f vec2_soa::get(int i) const
+{
+    return vec2f(xs[i], ys[i]);
+}
+
+void vec2_soa::set(int i, const vec2f &v)
+{
+    xs[i] = v.x;
+    ys[i] = v.y;
+}
+
+void vec2_soa::swap_remove(int i)
+{
+    xs[i] = xs.back();
+    ys[i] = ys.back();
+    xs.pop_back();
+    ys.pop_back();
+}
+
+void vec2_soa::translate(float dx, float dy)
+{
+    int n = size();
+    float *x = xs.data(), *y = ys.data();
+    for (int i = 0; i < n; i++)
+        x[i] += dx;
+    for (int i = 0; i < n; i++)
+        y[i] += dy;
+}
+
+#if defined(FX_X86)
+
+FX_TARGET("avx2,fma") static int __soa_apply_avx2(const transform &t, float *xs, float *ys, int n)
+{
+    __m256 m00 = _mm256_set1_ps(t.m00), m01 = _mm256_set1_ps(t.m01), m02 = _mm256_set1_ps(t.m02);
+    __m256 m10 = _mm256_set1_ps(t.m10), m11 = _mm256_set1_ps(t.m11), m12 = _mm256_set1_ps(t.m12);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        _mm256_storeu_ps(xs + i, _mm256_fmadd_ps(x, m00, _mm256_fmadd_ps(y, m01, m02)));
+        _mm256_storeu_ps(ys + i, _mm256_fmadd_ps(x, m10, _mm256_fmadd_ps(y, m11, m12)));
+    }
+    return i;
+}
+
+#endif
+
+#if defined(FX_X86) && defined(__SSE2__)
+
+static int __soa_apply_sse2(const transform &t, float *xs, float *ys, int n)
+{
+    __m128 m00 = _mm_set1_ps(t.m00), m01 = _mm_set1_ps(t.m01), m02 = _mm_set1_ps(t.m02);
+    __m128 m10 = _mm_set1_ps(t.m10), m11 = _mm_set1_ps(t.m11), m12 = _mm_set1_ps(t.m12);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        _mm_storeu_ps(xs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m01)), m02));
+        _mm_storeu_ps(ys + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m10), _mm_mul_ps(y, m11)), m12));
+    }
+    return i;
+}
+
+#endif
+
+void vec2_soa::apply(const transform &t)
+{
+    int n = size();
+    float *x = xs.data(), *y = ys.data();
+    int i = 0;
+#if defined(FX_X86)
+    if (cpu_has_avx2())
+        i = __soa_apply_avx2(t, x, y, n);
+#endif
+#if defined(FX_X86) && defined(__SSE2__)
+    if (i == 0)
+        i = __soa_apply_sse2(t, x, y, n);
+#endif
+    for (; i < n; i++)
+    {
+        float xx = x[i], yy = y[i];
+        x[i] = t.m00 * xx + t.m01 * yy + t.m02;
+        y[i] = t.m10 * xx + t.m11 * yy + t.m12;
+    }
+}
+
+void vec2_soa::pack(float *xy) const
+{
+    int n = size();
+    for (int i = 0; i < n; i++)
+    {
+        xy[i * 2] = xs[i];
+        xy[i * 2 + 1] = ys[i];
+    }
+}
+
+void vec2_soa::unpack(const float *xy, int n)
+{
+    resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        xs[i] = xy[i * 2];
+        ys[i] = xy[i * 2 + 1];
+    }
+}
+
 } // namespace flux
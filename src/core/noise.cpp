@@ -0,0 +1,1728 @@
+#include <core/noise.h>
+#include <core/log.h>
+#include <core/simd.h>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace flux
+{
+
+void noise::generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out)
+{
+    for (int k = 0; k < nz; k++)
+        for (int j = 0; j < ny; j++)
+            for (int i = 0; i < nx; i++)
+                *out++ = (float)generate(origin.x + step.x * i, origin.y + step.y * j, origin.z + step.z * k);
+}
+
+void noise::generate_points(const double *x, const double *y, const double *z, int n, float *out)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = (float)generate(x[i], y[i], z[i]);
+}
+
+// a batch of perlin samples, given as the fractions of their cells.
+// the 8 corner hashes are looked up beforehand (h[c * n + i] for corner c), so the kernels only do arithmetic.
+struct __perlin_batch
+{
+    const int *h;
+    const float *fx, *fy, *fz;
+    int n;
+    float *out;
+};
+
+static inline float __fadef(float t)
+{
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline float __lerpf(float t, float a, float b)
+{
+    return a + t * (b - a);
+}
+
+// the same as __noise_perlin::grad, without branches:
+// bit 2 picks y or z, bit 0 & 1 flip the signs.
+static inline float __gradf(int h, float x, float y, float z)
+{
+    float a = (h & 1) ? -x : x;
+    float b = (h & 4) ? z : y;
+    return a + ((h & 2) ? -b : b);
+}
+
+static void __perlin_batch_scalar(const __perlin_batch &r, int from)
+{
+    const int n = r.n;
+    for (int i = from; i < n; i++)
+    {
+        float x = r.fx[i], y = r.fy[i], z = r.fz[i];
+        float u = __fadef(x), v = __fadef(y), w = __fadef(z);
+        float x1 = x - 1, y1 = y - 1, z1 = z - 1;
+        float res =
+            __lerpf(w,
+                    __lerpf(v, __lerpf(u, __gradf(r.h[i], x, y, z), __gradf(r.h[n + i], x1, y, z)),
+                            __lerpf(u, __gradf(r.h[2 * n + i], x, y1, z), __gradf(r.h[3 * n + i], x1, y1, z))),
+                    __lerpf(v, __lerpf(u, __gradf(r.h[4 * n + i], x, y, z1), __gradf(r.h[5 * n + i], x1, y, z1)),
+                            __lerpf(u, __gradf(r.h[6 * n + i], x, y1, z1), __gradf(r.h[7 * n + i], x1, y1, z1))));
+        r.out[i] = (res + 1.0f) * 0.5f;
+    }
+}
+
+#if defined(FX_X86) && defined(__SSE2__)
+
+static inline __m128 __fade4(__m128 t)
+{
+    return _mm_mul_ps(
+        _mm_mul_ps(_mm_mul_ps(t, t), t),
+        _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15))), _mm_set1_ps(10)));
+}
+
+static inline __m128 __lerp4(__m128 t, __m128 a, __m128 b)
+{
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+static inline __m128 __grad4(__m128i h, __m128 x, __m128 y, __m128 z)
+{
+    __m128 use_z = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), _mm_set1_epi32(4)));
+    __m128 b = _mm_or_ps(_mm_and_ps(use_z, z), _mm_andnot_ps(use_z, y));
+    __m128 sa = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 sb = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(x, sa), _mm_xor_ps(b, sb));
+}
+
+static inline __m128i __hash4(const __perlin_batch &r, int c, int i)
+{
+    return _mm_loadu_si128((const __m128i *)(r.h + c * r.n + i));
+}
+
+static int __perlin_batch_sse2(const __perlin_batch &r)
+{
+    const int n = r.n;
+    const __m128 one = _mm_set1_ps(1), half = _mm_set1_ps(0.5f);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(r.fx + i), y = _mm_loadu_ps(r.fy + i), z = _mm_loadu_ps(r.fz + i);
+        __m128 x1 = _mm_sub_ps(x, one), y1 = _mm_sub_ps(y, one), z1 = _mm_sub_ps(z, one);
+        __m128 u = __fade4(x), v = __fade4(y), w = __fade4(z);
+
+        __m128 res = __lerp4(w,
+                             __lerp4(v, __lerp4(u, __grad4(__hash4(r, 0, i), x, y, z), __grad4(__hash4(r, 1, i), x1, y, z)),
+                                     __lerp4(u, __grad4(__hash4(r, 2, i), x, y1, z), __grad4(__hash4(r, 3, i), x1, y1, z))),
+                             __lerp4(v, __lerp4(u, __grad4(__hash4(r, 4, i), x, y, z1), __grad4(__hash4(r, 5, i), x1, y, z1)),
+                                     __lerp4(u, __grad4(__hash4(r, 6, i), x, y1, z1), __grad4(__hash4(r, 7, i), x1, y1, z1))));
+        _mm_storeu_ps(r.out + i, _mm_mul_ps(_mm_add_ps(res, one), half));
+    }
+    return i;
+}
+
+#endif
+
+#if defined(FX_X86)
+
+#define FX_AVX2 FX_TARGET("avx2,fma")
+
+FX_AVX2 static inline __m256 __fade8(__m256 t)
+{
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t),
+                         _mm256_fmadd_ps(t, _mm256_fmsub_ps(t, _mm256_set1_ps(6), _mm256_set1_ps(15)),
+                                         _mm256_set1_ps(10)));
+}
+
+FX_AVX2 static inline __m256 __lerp8(__m256 t, __m256 a, __m256 b)
+{
+    return _mm256_fmadd_ps(t, _mm256_sub_ps(b, a), a);
+}
+
+FX_AVX2 static inline __m256 __grad8(__m256i h, __m256 x, __m256 y, __m256 z)
+{
+    // blendv only looks at the sign bit, so shift bit 2 up there.
+    __m256 use_z = _mm256_castsi256_ps(_mm256_slli_epi32(h, 29));
+    __m256 b = _mm256_blendv_ps(y, z, use_z);
+    __m256 sa = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 sb = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    return _mm256_add_ps(_mm256_xor_ps(x, sa), _mm256_xor_ps(b, sb));
+}
+
+FX_AVX2 static inline __m256i __hash8(const __perlin_batch &r, int c, int i)
+{
+    return _mm256_loadu_si256((const __m256i *)(r.h + c * r.n + i));
+}
+
+FX_AVX2 static int __perlin_batch_avx2(const __perlin_batch &r)
+{
+    const int n = r.n;
+    const __m256 one = _mm256_set1_ps(1), half = _mm256_set1_ps(0.5f);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(r.fx + i), y = _mm256_loadu_ps(r.fy + i), z = _mm256_loadu_ps(r.fz + i);
+        __m256 x1 = _mm256_sub_ps(x, one), y1 = _mm256_sub_ps(y, one), z1 = _mm256_sub_ps(z, one);
+        __m256 u = __fade8(x), v = __fade8(y), w = __fade8(z);
+
+        __m256 res = __lerp8(w,
+                             __lerp8(v, __lerp8(u, __grad8(__hash8(r, 0, i), x, y, z), __grad8(__hash8(r, 1, i), x1, y, z)),
+                                     __lerp8(u, __grad8(__hash8(r, 2, i), x, y1, z), __grad8(__hash8(r, 3, i), x1, y1, z))),
+                             __lerp8(v, __lerp8(u, __grad8(__hash8(r, 4, i), x, y, z1), __grad8(__hash8(r, 5, i), x1, y, z1)),
+                                     __lerp8(u, __grad8(__hash8(r, 6, i), x, y1, z1), __grad8(__hash8(r, 7, i), x1, y1, z1))));
+        _mm256_storeu_ps(r.out + i, _mm256_mul_ps(_mm256_add_ps(res, one), half));
+    }
+    return i;
+}
+
+#undef FX_AVX2
+
+#endif
+
+static void __perlin_batch_run(const __perlin_batch &r)
+{
+    int done = 0;
+#if defined(FX_X86)
+    if (cpu_has_avx2())
+        done = __perlin_batch_avx2(r);
+#if defined(__SSE2__)
+    else
+        done = __perlin_batch_sse2(r);
+#endif
+#endif
+    __perlin_batch_scalar(r, done);
+}
+
+// a batch of 2d simplex samples, given as the offsets (x0, y0) from their base corners.
+// #i1 is 1 if the sample is in the lower triangle of its skewed cell, else 0.
+// the 3 corner hashes are looked up beforehand (h[c * n + i] for corner c).
+struct __simplex2_batch
+{
+    const int *h;
+    const float *x0, *y0, *i1;
+    int n;
+    float *out;
+};
+
+static constexpr float __SIMPLEX_G2 = 0.21132486540518713f; // (3 - sqrt(3)) / 6
+
+// one of 8 gradients: diagonals (±1, ±1) for h < 4, then the axes.
+// the simd kernels get the same ones with bit tricks: bit 2 picks a diagonal or an axis,
+// bit 0 flips x (or picks y for axes), bit 1 flips y (or the axis).
+static constexpr float __GRAD2X[8] = {1, -1, 1, -1, 1, 0, -1, 0};
+static constexpr float __GRAD2Y[8] = {1, 1, -1, -1, 0, 1, 0, -1};
+
+// table lookups & max instead of branches, the hashes are random so branches would mispredict a lot.
+static inline float __corner2f(int h, float x, float y)
+{
+    float t = std::max(0.5f - x * x - y * y, 0.0f);
+    t *= t;
+    return t * t * (__GRAD2X[h & 7] * x + __GRAD2Y[h & 7] * y);
+}
+
+static inline float __simplex2f(int h0, int h1, int h2, float x0, float y0, float i1)
+{
+    const float G2 = __SIMPLEX_G2;
+    float v = __corner2f(h0, x0, y0) + __corner2f(h1, x0 - i1 + G2, y0 - (1 - i1) + G2) +
+              __corner2f(h2, x0 - 1 + 2 * G2, y0 - 1 + 2 * G2);
+    return (70 * v + 1) * 0.5f;
+}
+
+static void __simplex2_batch_scalar(const __simplex2_batch &r, int from)
+{
+    const int n = r.n;
+    for (int i = from; i < n; i++)
+        r.out[i] = __simplex2f(r.h[i], r.h[n + i], r.h[2 * n + i], r.x0[i], r.y0[i], r.i1[i]);
+}
+
+// samples walked in float from one anchor, see #simplex2_row: at most this many,
+// and at most this far from it in skewed space (float steps lose about 1e-7 per unit walked).
+static constexpr int __SIMPLEX_ROW_BLOCK = 64;
+static constexpr double __SIMPLEX_ROW_SPAN = 8;
+
+// a row of 2d simplex samples, walked in the skewed space from an anchor lattice point (#iu, #iv).
+// sample i is at (u0, v0) + (du, dv) * i in skewed space, and at (bx + dx * i, by) from the anchor.
+// it finds the base corners (as hash indices #ii, #jj) and the offsets from them.
+struct __simplex2_row
+{
+    float u0, v0, du, dv;
+    float bx, dx, by;
+    int iu, iv;
+    int n;
+    int *ii, *jj, *o;
+    float *x0, *y0, *i1;
+};
+
+static void __simplex2_row_scalar(const __simplex2_row &r, int from)
+{
+    const float g2 = __SIMPLEX_G2;
+    for (int i = from; i < r.n; i++)
+    {
+        float u = r.u0 + r.du * i, v = r.v0 + r.dv * i;
+        int a = (int)u, b = (int)v;
+        a -= u < a;
+        b -= v < b;
+        float t = (a + b) * g2;
+        float x = r.bx + r.dx * i - a + t;
+        float y = r.by - b + t;
+        int o = x > y;
+
+        r.ii[i] = (r.iu + a) & 255;
+        r.jj[i] = (r.iv + b) & 255;
+        r.o[i] = o;
+        r.x0[i] = x;
+        r.y0[i] = y;
+        r.i1[i] = (float)o;
+    }
+}
+
+#if defined(FX_X86) && defined(__SSE2__)
+
+static inline __m128 __corner2_4(__m128i h, __m128 x, __m128 y)
+{
+    __m128 t = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))),
+                          _mm_setzero_ps());
+    t = _mm_mul_ps(t, t);
+    t = _mm_mul_ps(t, t);
+
+    __m128 sa = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 sb = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    __m128 use_y = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 use_axis = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), _mm_set1_epi32(4)));
+    __m128 diag = _mm_add_ps(_mm_xor_ps(x, sa), _mm_xor_ps(y, sb));
+    __m128 axis = _mm_xor_ps(_mm_or_ps(_mm_and_ps(use_y, y), _mm_andnot_ps(use_y, x)), sb);
+    __m128 g = _mm_or_ps(_mm_and_ps(use_axis, axis), _mm_andnot_ps(use_axis, diag));
+    return _mm_mul_ps(t, g);
+}
+
+static inline __m128i __shash4(const __simplex2_batch &r, int c, int i)
+{
+    return _mm_loadu_si128((const __m128i *)(r.h + c * r.n + i));
+}
+
+static int __simplex2_row_sse2(const __simplex2_row &r)
+{
+    const __m128 one = _mm_set1_ps(1), g2 = _mm_set1_ps(__SIMPLEX_G2), lane = _mm_setr_ps(0, 1, 2, 3);
+    const __m128i m255 = _mm_set1_epi32(255), ione = _mm_set1_epi32(1);
+    const __m128i iu = _mm_set1_epi32(r.iu), iv = _mm_set1_epi32(r.iv);
+
+    int i = 0;
+    for (; i + 4 <= r.n; i += 4)
+    {
+        __m128 fi = _mm_add_ps(_mm_set1_ps((float)i), lane);
+        __m128 u = _mm_add_ps(_mm_set1_ps(r.u0), _mm_mul_ps(_mm_set1_ps(r.du), fi));
+        __m128 v = _mm_add_ps(_mm_set1_ps(r.v0), _mm_mul_ps(_mm_set1_ps(r.dv), fi));
+
+        // floor without sse4.1: truncate, then step down where it rounded up.
+        __m128i a = _mm_cvttps_epi32(u), b = _mm_cvttps_epi32(v);
+        __m128 af = _mm_cvtepi32_ps(a), bf = _mm_cvtepi32_ps(b);
+        __m128 ma = _mm_cmplt_ps(u, af), mb = _mm_cmplt_ps(v, bf);
+        a = _mm_add_epi32(a, _mm_castps_si128(ma));
+        b = _mm_add_epi32(b, _mm_castps_si128(mb));
+        af = _mm_sub_ps(af, _mm_and_ps(ma, one));
+        bf = _mm_sub_ps(bf, _mm_and_ps(mb, one));
+
+        __m128 t = _mm_mul_ps(_mm_add_ps(af, bf), g2);
+        __m128 x = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_set1_ps(r.bx), _mm_mul_ps(_mm_set1_ps(r.dx), fi)), af), t);
+        __m128 y = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(r.by), bf), t);
+        __m128 o = _mm_cmpgt_ps(x, y);
+
+        _mm_storeu_si128((__m128i *)(r.ii + i), _mm_and_si128(_mm_add_epi32(iu, a), m255));
+        _mm_storeu_si128((__m128i *)(r.jj + i), _mm_and_si128(_mm_add_epi32(iv, b), m255));
+        _mm_storeu_si128((__m128i *)(r.o + i), _mm_and_si128(_mm_castps_si128(o), ione));
+        _mm_storeu_ps(r.x0 + i, x);
+        _mm_storeu_ps(r.y0 + i, y);
+        _mm_storeu_ps(r.i1 + i, _mm_and_ps(o, one));
+    }
+    return i;
+}
+
+static int __simplex2_batch_sse2(const __simplex2_batch &r)
+{
+    const int n = r.n;
+    const __m128 one = _mm_set1_ps(1), g2 = _mm_set1_ps(__SIMPLEX_G2), g2m1 = _mm_set1_ps(2 * __SIMPLEX_G2 - 1);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x0 = _mm_loadu_ps(r.x0 + i), y0 = _mm_loadu_ps(r.y0 + i), i1 = _mm_loadu_ps(r.i1 + i);
+        __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+        __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_sub_ps(one, i1)), g2);
+        __m128 v = _mm_add_ps(_mm_add_ps(__corner2_4(__shash4(r, 0, i), x0, y0), __corner2_4(__shash4(r, 1, i), x1, y1)),
+                              __corner2_4(__shash4(r, 2, i), _mm_add_ps(x0, g2m1), _mm_add_ps(y0, g2m1)));
+        _mm_storeu_ps(r.out + i, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(70)), one), _mm_set1_ps(0.5f)));
+    }
+    return i;
+}
+
+#endif
+
+#if defined(FX_X86)
+
+#define FX_AVX2 FX_TARGET("avx2,fma")
+
+FX_AVX2 static inline __m256 __corner2_8(__m256i h, __m256 x, __m256 y)
+{
+    __m256 t = _mm256_max_ps(_mm256_fnmadd_ps(x, x, _mm256_fnmadd_ps(y, y, _mm256_set1_ps(0.5f))),
+                             _mm256_setzero_ps());
+    t = _mm256_mul_ps(t, t);
+    t = _mm256_mul_ps(t, t);
+
+    __m256 sa = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 sb = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    __m256 diag = _mm256_add_ps(_mm256_xor_ps(x, sa), _mm256_xor_ps(y, sb));
+    // blendv only looks at the sign bit, so shift the picking bits up there.
+    __m256 axis = _mm256_xor_ps(_mm256_blendv_ps(x, y, sa), sb);
+    __m256 g = _mm256_blendv_ps(diag, axis, _mm256_castsi256_ps(_mm256_slli_epi32(h, 29)));
+    return _mm256_mul_ps(t, g);
+}
+
+FX_AVX2 static inline __m256i __shash8(const __simplex2_batch &r, int c, int i)
+{
+    return _mm256_loadu_si256((const __m256i *)(r.h + c * r.n + i));
+}
+
+FX_AVX2 static int __simplex2_row_avx2(const __simplex2_row &r)
+{
+    const __m256 one = _mm256_set1_ps(1), g2 = _mm256_set1_ps(__SIMPLEX_G2);
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i m255 = _mm256_set1_epi32(255), ione = _mm256_set1_epi32(1);
+    const __m256i iu = _mm256_set1_epi32(r.iu), iv = _mm256_set1_epi32(r.iv);
+
+    int i = 0;
+    for (; i + 8 <= r.n; i += 8)
+    {
+        __m256 fi = _mm256_add_ps(_mm256_set1_ps((float)i), lane);
+        __m256 af = _mm256_floor_ps(_mm256_fmadd_ps(_mm256_set1_ps(r.du), fi, _mm256_set1_ps(r.u0)));
+        __m256 bf = _mm256_floor_ps(_mm256_fmadd_ps(_mm256_set1_ps(r.dv), fi, _mm256_set1_ps(r.v0)));
+
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(af, bf), g2);
+        __m256 x = _mm256_add_ps(_mm256_sub_ps(_mm256_fmadd_ps(_mm256_set1_ps(r.dx), fi, _mm256_set1_ps(r.bx)), af), t);
+        __m256 y = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(r.by), bf), t);
+        __m256 o = _mm256_cmp_ps(x, y, _CMP_GT_OQ);
+
+        __m256i a = _mm256_cvttps_epi32(af), b = _mm256_cvttps_epi32(bf);
+        _mm256_storeu_si256((__m256i *)(r.ii + i), _mm256_and_si256(_mm256_add_epi32(iu, a), m255));
+        _mm256_storeu_si256((__m256i *)(r.jj + i), _mm256_and_si256(_mm256_add_epi32(iv, b), m255));
+        _mm256_storeu_si256((__m256i *)(r.o + i), _mm256_and_si256(_mm256_castps_si256(o), ione));
+        _mm256_storeu_ps(r.x0 + i, x);
+        _mm256_storeu_ps(r.y0 + i, y);
+        _mm256_storeu_ps(r.i1 + i, _mm256_and_ps(o, one));
+    }
+    return i;
+}
+
+FX_AVX2 static int __simplex2_batch_avx2(const __simplex2_batch &r)
+{
+    const int n = r.n;
+    const __m256 one = _mm256_set1_ps(1), g2 = _mm256_set1_ps(__SIMPLEX_G2);
+    const __m256 g2m1 = _mm256_set1_ps(2 * __SIMPLEX_G2 - 1);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(r.x0 + i), y0 = _mm256_loadu_ps(r.y0 + i), i1 = _mm256_loadu_ps(r.i1 + i);
+        __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, i1), g2);
+        __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_sub_ps(one, i1)), g2);
+        __m256 v = _mm256_add_ps(
+            _mm256_add_ps(__corner2_8(__shash8(r, 0, i), x0, y0), __corner2_8(__shash8(r, 1, i), x1, y1)),
+            __corner2_8(__shash8(r, 2, i), _mm256_add_ps(x0, g2m1), _mm256_add_ps(y0, g2m1)));
+        _mm256_storeu_ps(r.out + i, _mm256_mul_ps(_mm256_fmadd_ps(v, _mm256_set1_ps(70), one), _mm256_set1_ps(0.5f)));
+    }
+    return i;
+}
+
+#undef FX_AVX2
+
+#endif
+
+static void __simplex2_row_run(const __simplex2_row &r)
+{
+    int done = 0;
+#if defined(FX_X86)
+    if (cpu_has_avx2())
+        done = __simplex2_row_avx2(r);
+#if defined(__SSE2__)
+    else
+        done = __simplex2_row_sse2(r);
+#endif
+#endif
+    __simplex2_row_scalar(r, done);
+}
+
+static void __simplex2_batch_run(const __simplex2_batch &r)
+{
+    int done = 0;
+#if defined(FX_X86)
+    if (cpu_has_avx2())
+        done = __simplex2_batch_avx2(r);
+#if defined(__SSE2__)
+    else
+        done = __simplex2_batch_sse2(r);
+#endif
+#endif
+    __simplex2_batch_scalar(r, done);
+}
+
+// scratch buffers of the batched paths. each thread keeps its own, and they only grow, so sampling does not
+// allocate once warm. calls can nest (a graph sampling another graph), so every nesting level has its own set.
+struct __scratch
+{
+    std::vector<int> i;
+    std::vector<float> f;
+    std::vector<double> d;
+};
+
+static thread_local std::deque<__scratch> __scratch_levels;
+static thread_local size_t __scratch_depth = 0;
+
+// holds the scratch of the current nesting level while alive.
+struct __scratch_lease
+{
+    __scratch &s;
+
+    __scratch_lease() : s(__take())
+    {
+    }
+
+    ~__scratch_lease()
+    {
+        __scratch_depth--;
+    }
+
+    static __scratch &__take()
+    {
+        if (__scratch_depth == __scratch_levels.size())
+            __scratch_levels.emplace_back();
+        return __scratch_levels[__scratch_depth++];
+    }
+};
+
+// a seeded shuffle of 0..255, repeated twice so that p[i + 1] never needs a wrap.
+static void __permutation(long seed, int *p)
+{
+    auto rd = make_random(seed);
+
+    int perm[256];
+    for (int i = 0; i < 256; i++)
+    {
+        perm[i] = i;
+    }
+
+    for (int i = 255; i > 0; i--)
+    {
+        int j = rd->next_int(i + 1);
+        int temp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = temp;
+    }
+
+    for (int i = 0; i < 256; i++)
+    {
+        p[i] = p[i + 256] = perm[i];
+    }
+}
+
+struct __noise_perlin : noise
+{
+    int p[512];
+
+    void init()
+    {
+        __permutation(seed, p);
+    }
+
+    inline int fast_floor(double x) const
+    {
+        int xi = (int)x;
+        return x < xi ? xi - 1 : xi;
+    }
+
+    inline double fade(double t) const
+    {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    }
+
+    inline double lerp(double t, double a, double b) const
+    {
+        return a + t * (b - a);
+    }
+
+    inline double grad(int hash, double x, double y, double z) const
+    {
+        int h = hash & 15;
+
+        switch (h & 7)
+        {
+        case 0:
+            return x + y;
+        case 1:
+            return -x + y;
+        case 2:
+            return x - y;
+        case 3:
+            return -x - y;
+        case 4:
+            return x + z;
+        case 5:
+            return -x + z;
+        case 6:
+            return x - z;
+        case 7:
+            return -x - z;
+        default:
+            return 0;
+        }
+    }
+
+    // look up the 8 corner hashes of sample #i, given p[X] & p[X + 1].
+    // the gathers are done in scalar code. simd gathers are not faster than plain loads on most cpus.
+    inline void hash_corners(int px0, int px1, int Y, int Z, int *h, int i, int n) const
+    {
+        int A = px0 + Y;
+        int AA = p[A] + Z;
+        int AB = p[A + 1] + Z;
+        int B = px1 + Y;
+        int BA = p[B] + Z;
+        int BB = p[B + 1] + Z;
+        h[i] = p[AA];
+        h[n + i] = p[BA];
+        h[2 * n + i] = p[AB];
+        h[3 * n + i] = p[BB];
+        h[4 * n + i] = p[AA + 1];
+        h[5 * n + i] = p[BA + 1];
+        h[6 * n + i] = p[AB + 1];
+        h[7 * n + i] = p[BB + 1];
+    }
+
+    double generate(double x, double y, double z) override
+    {
+        int X = fast_floor(x) & 255;
+        int Y = fast_floor(y) & 255;
+        int Z = fast_floor(z) & 255;
+
+        x -= fast_floor(x);
+        y -= fast_floor(y);
+        z -= fast_floor(z);
+
+        double u = fade(x);
+        double v = fade(y);
+        double w = fade(z);
+
+        int A = p[X] + Y;
+        int AA = p[A] + Z;
+        int AB = p[A + 1] + Z;
+        int B = p[X + 1] + Y;
+        int BA = p[B] + Z;
+        int BB = p[B + 1] + Z;
+
+        double result = lerp(w,
+                             lerp(v, lerp(u, grad(p[AA], x, y, z), grad(p[BA], x - 1, y, z)),
+                                  lerp(u, grad(p[AB], x, y - 1, z), grad(p[BB], x - 1, y - 1, z))),
+                             lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1), grad(p[BA + 1], x - 1, y, z - 1)),
+                                  lerp(u, grad(p[AB + 1], x, y - 1, z - 1), grad(p[BB + 1], x - 1, y - 1, z - 1))));
+
+        return (result + 1.0) * 0.5;
+    }
+
+    void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out) override
+    {
+        if (nx <= 0 || ny <= 0 || nz <= 0)
+            return;
+
+        __scratch_lease lease;
+        lease.s.i.resize(10 * (size_t)nx);
+        lease.s.f.resize(3 * (size_t)nx);
+        int *px0 = lease.s.i.data(), *px1 = px0 + nx, *h = px1 + nx;
+        float *fx = lease.s.f.data(), *fy = fx + nx, *fz = fy + nx;
+
+        // x only depends on i, so its cell & fraction are shared by every row.
+        // fractions are taken in double, so far-away origins keep their precision.
+        for (int i = 0; i < nx; i++)
+        {
+            double x = origin.x + step.x * i;
+            int X = fast_floor(x) & 255;
+            px0[i] = p[X];
+            px1[i] = p[X + 1];
+            fx[i] = (float)(x - fast_floor(x));
+        }
+
+        for (int k = 0; k < nz; k++)
+        {
+            double z = origin.z + step.z * k;
+            int Z = fast_floor(z) & 255;
+            std::fill(fz, fz + nx, (float)(z - fast_floor(z)));
+
+            for (int j = 0; j < ny; j++)
+            {
+                double y = origin.y + step.y * j;
+                int Y = fast_floor(y) & 255;
+                std::fill(fy, fy + nx, (float)(y - fast_floor(y)));
+
+                for (int i = 0; i < nx; i++)
+                    hash_corners(px0[i], px1[i], Y, Z, h, i, nx);
+
+                __perlin_batch r;
+                r.h = h;
+                r.fx = fx;
+                r.fy = fy;
+                r.fz = fz;
+                r.n = nx;
+                r.out = out + ((size_t)k * ny + j) * nx;
+                __perlin_batch_run(r);
+            }
+        }
+    }
+
+    void generate_points(const double *x, const double *y, const double *z, int n, float *out) override
+    {
+        if (n <= 0)
+            return;
+
+        __scratch_lease lease;
+        lease.s.i.resize(8 * (size_t)n);
+        lease.s.f.resize(3 * (size_t)n);
+        int *h = lease.s.i.data();
+        float *f = lease.s.f.data();
+        for (int i = 0; i < n; i++)
+        {
+            int X = fast_floor(x[i]) & 255;
+            int Y = fast_floor(y[i]) & 255;
+            int Z = fast_floor(z[i]) & 255;
+            f[i] = (float)(x[i] - fast_floor(x[i]));
+            f[n + i] = (float)(y[i] - fast_floor(y[i]));
+            f[2 * n + i] = (float)(z[i] - fast_floor(z[i]));
+            hash_corners(p[X], p[X + 1], Y, Z, h, i, n);
+        }
+
+        __perlin_batch r;
+        r.h = h;
+        r.fx = f;
+        r.fy = f + n;
+        r.fz = f + 2 * n;
+        r.n = n;
+        r.out = out;
+        __perlin_batch_run(r);
+    }
+};
+
+struct __noise_voronoi : voronoi
+{
+    // a feature point, as an offset in its cell, with the value of the cell it falls in.
+    struct feature
+    {
+        double x, y, z, cell;
+    };
+
+    // the cached feature points of a box of cells.
+    struct feature_box
+    {
+        int x0, y0, z0;
+        int sx, sy, sz;
+        std::vector<feature> points;
+
+        const feature &at(int i, int j, int k) const
+        {
+            return points[((size_t)(k - z0) * sy + (j - y0)) * sx + (i - x0)];
+        }
+    };
+
+    // boxes larger than this (16 mb) are not cached, samples hash the cells on the fly instead.
+    static constexpr size_t MAX_CACHED_CELLS = 1 << 19;
+    // slack of the shell tests, so a rounding in the bounds never skips a cell that is nearer.
+    static constexpr double SHELL_SLACK = 1e-9;
+
+    inline int floor(double v)
+    {
+        int i = (int)v;
+        return v >= i ? i : i - 1;
+    }
+
+    inline double seedl(int x, int y, int z, long seed)
+    {
+        long v1 = (x + 2687 * y + 433 * z + 941 * seed) & INT_MAX;
+        long v2 = (v1 * (v1 * v1 * 113 + 653) + 2819) & INT_MAX;
+        return 1 - (double)v2 / INT_MAX;
+    }
+
+    feature make_feature(int i, int j, int k)
+    {
+        double ox = seedl(i, j, k, seed);
+        double oy = seedl(i, j, k, seed + 1);
+        double oz = seedl(i, j, k, seed + 2);
+        return {ox, oy, oz, seedl(floor(i + ox), floor(j + oy), floor(k + oz), 0)};
+    }
+
+    // squared distance from a sample at fraction #f of its cell to the cell at offset #o on that axis.
+    static inline double axis_gap2(int o, double f)
+    {
+        double g = o > 0 ? o - f : (o < 0 ? f - o - 1 : 0);
+        return g > 0 ? g * g : 0;
+    }
+
+    // find f1 & f2 around the sample at (x, y, z), in the cell (x0, y0, z0).
+    // feature points are always inside their cells, so only the 3x3x3 neighbourhood is scanned first.
+    // the outer shell of the 5x5x5 block is only visited when it could still hold something closer than f2.
+    // distances are taken in double from the absolute feature points, like a full 5x5x5 scan does,
+    // so the nearest cell is the same as the one of that scan.
+    template <typename F>
+    inline void search(double x, double y, double z, int x0, int y0, int z0, F &&get, double &f1, double &f2,
+                       double &cell)
+    {
+        double d1 = 1e300, d2 = 1e300;
+        double c = 0;
+        double fx = x - x0, fy = y - y0, fz = z - z0;
+
+        auto visit = [&](int di, int dj, int dk) {
+            const feature &p = get(x0 + di, y0 + dj, z0 + dk);
+            double xd = (x0 + di) + p.x - x;
+            double yd = (y0 + dj) + p.y - y;
+            double zd = (z0 + dk) + p.z - z;
+            double d = xd * xd + yd * yd + zd * zd;
+            if (d < d1)
+            {
+                d2 = d1;
+                d1 = d;
+                c = p.cell;
+            }
+            else if (d < d2)
+                d2 = d;
+        };
+
+        for (int dk = -1; dk <= 1; dk++)
+            for (int dj = -1; dj <= 1; dj++)
+                for (int di = -1; di <= 1; di++)
+                    visit(di, dj, dk);
+
+        double near = std::min({axis_gap2(-2, fx), axis_gap2(2, fx), axis_gap2(-2, fy), axis_gap2(2, fy),
+                               axis_gap2(-2, fz), axis_gap2(2, fz)});
+        if (d2 + SHELL_SLACK > near)
+        {
+            for (int dk = -2; dk <= 2; dk++)
+                for (int dj = -2; dj <= 2; dj++)
+                    for (int di = -2; di <= 2; di++)
+                    {
+                        if (std::abs(di) < 2 && std::abs(dj) < 2 && std::abs(dk) < 2)
+                            continue;
+                        if (axis_gap2(di, fx) + axis_gap2(dj, fy) + axis_gap2(dk, fz) >= d2 + SHELL_SLACK)
+                            continue;
+                        visit(di, dj, dk);
+                    }
+        }
+
+        f1 = std::sqrt(d1);
+        f2 = std::sqrt(d2);
+        cell = c;
+    }
+
+    void sample(double x, double y, double z, double &f1, double &f2, double &cell)
+    {
+        feature tmp;
+        auto get = [&](int i, int j, int k) -> const feature & { return tmp = make_feature(i, j, k); };
+        search(x, y, z, floor(x), floor(y), floor(z), get, f1, f2, cell);
+    }
+
+    double generate(double x, double y, double z) override
+    {
+        double f1, f2, cell;
+        sample(x, y, z, f1, f2, cell);
+        return cell;
+    }
+
+    void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out) override
+    {
+        generate_cells(origin, step, nx, ny, nz, nullptr, nullptr, out);
+    }
+
+    void generate_cells(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *f1, float *f2,
+                        float *cell) override
+    {
+        if (nx <= 0 || ny <= 0 || nz <= 0)
+            return;
+
+        // neighbouring samples share most of their cells, so hash every cell the grid touches only once.
+        int lo[3], hi[3];
+        const double o[3] = {origin.x, origin.y, origin.z}, st[3] = {step.x, step.y, step.z};
+        const int n[3] = {nx, ny, nz};
+        size_t cells = 1;
+        for (int a = 0; a < 3; a++)
+        {
+            int c0 = floor(o[a]), c1 = floor(o[a] + st[a] * (n[a] - 1));
+            lo[a] = std::min(c0, c1) - 2;
+            hi[a] = std::max(c0, c1) + 2;
+            cells *= (size_t)(hi[a] - lo[a] + 1);
+        }
+
+        // kept per thread like #__scratch, so a warm thread fills the box without allocating.
+        // sampling voronoi never samples another noise, so calls cannot nest.
+        static thread_local feature_box box;
+        bool cached = cells <= MAX_CACHED_CELLS;
+        if (cached)
+        {
+            box.x0 = lo[0], box.y0 = lo[1], box.z0 = lo[2];
+            box.sx = hi[0] - lo[0] + 1, box.sy = hi[1] - lo[1] + 1, box.sz = hi[2] - lo[2] + 1;
+            box.points.resize(cells);
+            size_t idx = 0;
+            for (int k = lo[2]; k <= hi[2]; k++)
+                for (int j = lo[1]; j <= hi[1]; j++)
+                    for (int i = lo[0]; i <= hi[0]; i++)
+                        box.points[idx++] = make_feature(i, j, k);
+        }
+        auto get = [&](int i, int j, int k) -> const feature & { return box.at(i, j, k); };
+
+        size_t idx = 0;
+        for (int k = 0; k < nz; k++)
+        {
+            double z = o[2] + st[2] * k;
+            int z0 = floor(z);
+            for (int j = 0; j < ny; j++)
+            {
+                double y = o[1] + st[1] * j;
+                int y0 = floor(y);
+                for (int i = 0; i < nx; i++, idx++)
+                {
+                    double x = o[0] + st[0] * i;
+                    int x0 = floor(x);
+                    double v1, v2, vc;
+                    if (cached)
+                        search(x, y, z, x0, y0, z0, get, v1, v2, vc);
+                    else
+                        sample(x, y, z, v1, v2, vc);
+                    if (f1)
+                        f1[idx] = (float)v1;
+                    if (f2)
+                        f2[idx] = (float)v2;
+                    if (cell)
+                        cell[idx] = (float)vc;
+                }
+            }
+        }
+    }
+};
+
+// simplex noise (gustavson's formulation). a 2d sample only walks 3 corners, and a 3d one 4,
+// instead of the 8 of perlin noise. it also has no axis-aligned artefacts.
+// 2d batches run on the simd kernels above, 3d ones are scalar.
+struct __noise_simplex : noise
+{
+    static constexpr double F2 = 0.36602540378443865; // (sqrt(3) - 1) / 2
+    static constexpr double G2 = 0.21132486540518713; // (3 - sqrt(3)) / 6
+    static constexpr double F3 = 1.0 / 3;
+    static constexpr double G3 = 1.0 / 6;
+
+    static constexpr double GRAD3[12][3] = {{1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0}, {1, 0, 1}, {-1, 0, 1},
+                                            {1, 0, -1}, {-1, 0, -1}, {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}};
+
+    int dims = 3;
+    int p[512];
+    // p[i] % 12, to pick a gradient without a division.
+    int p12[512];
+
+    void init()
+    {
+        __permutation(seed, p);
+        for (int i = 0; i < 512; i++)
+            p12[i] = p[i] % 12;
+    }
+
+    inline int fast_floor(double x) const
+    {
+        int xi = (int)x;
+        return x < xi ? xi - 1 : xi;
+    }
+
+    inline double corner3(int gi, double x, double y, double z) const
+    {
+        double t = 0.6 - x * x - y * y - z * z;
+        if (t < 0)
+            return 0;
+        t *= t;
+        return t * t * (GRAD3[gi][0] * x + GRAD3[gi][1] * y + GRAD3[gi][2] * z);
+    }
+
+    // find the base corner, the offset from it, and the 3 corner hashes of a 2d sample.
+    inline void locate2(double x, double y, float &x0, float &y0, float &i1, int *h, int i, int n) const
+    {
+        double s = (x + y) * F2;
+        int ci = fast_floor(x + s);
+        int cj = fast_floor(y + s);
+        double t = (ci + cj) * G2;
+        double dx = x - (ci - t);
+        double dy = y - (cj - t);
+        int o = dx > dy ? 1 : 0;
+
+        int ii = ci & 255;
+        int jj = cj & 255;
+        h[i] = p[ii + p[jj]];
+        h[n + i] = p[ii + o + p[jj + 1 - o]];
+        h[2 * n + i] = p[ii + 1 + p[jj + 1]];
+        x0 = (float)dx;
+        y0 = (float)dy;
+        i1 = (float)o;
+    }
+
+    double simplex2(double x, double y) const
+    {
+        int h[3];
+        float x0, y0, i1;
+        locate2(x, y, x0, y0, i1, h, 0, 1);
+        return __simplex2f(h[0], h[1], h[2], x0, y0, i1);
+    }
+
+    // sample #n points given by #at into #out. #h & #f are scratch, of at least 3 * n each.
+    template <typename F> void simplex2_many(F &&at, int n, float *out, std::vector<int> &h, std::vector<float> &f) const
+    {
+        h.resize(3 * n);
+        f.resize(3 * n);
+        for (int i = 0; i < n; i++)
+        {
+            auto [x, y] = at(i);
+            locate2(x, y, f[i], f[n + i], f[2 * n + i], h.data(), i, n);
+        }
+        __simplex2_batch_run({h.data(), f.data(), f.data() + n, f.data() + 2 * n, n, out});
+    }
+
+    double simplex3(double x, double y, double z) const
+    {
+        double s = (x + y + z) * F3;
+        int i = fast_floor(x + s);
+        int j = fast_floor(y + s);
+        int k = fast_floor(z + s);
+        double t = (i + j + k) * G3;
+        double x0 = x - (i - t);
+        double y0 = y - (j - t);
+        double z0 = z - (k - t);
+
+        // which of the 6 tetrahedra of the skewed cube are we in.
+        int i1, j1, k1, i2, j2, k2;
+        if (x0 >= y0)
+        {
+            if (y0 >= z0)
+                i1 = 1, j1 = 0, k1 = 0, i2 = 1, j2 = 1, k2 = 0;
+            else if (x0 >= z0)
+                i1 = 1, j1 = 0, k1 = 0, i2 = 1, j2 = 0, k2 = 1;
+            else
+                i1 = 0, j1 = 0, k1 = 1, i2 = 1, j2 = 0, k2 = 1;
+        }
+        else
+        {
+            if (y0 < z0)
+                i1 = 0, j1 = 0, k1 = 1, i2 = 0, j2 = 1, k2 = 1;
+            else if (x0 < z0)
+                i1 = 0, j1 = 1, k1 = 0, i2 = 0, j2 = 1, k2 = 1;
+            else
+                i1 = 0, j1 = 1, k1 = 0, i2 = 1, j2 = 1, k2 = 0;
+        }
+
+        double x1 = x0 - i1 + G3, y1 = y0 - j1 + G3, z1 = z0 - k1 + G3;
+        double x2 = x0 - i2 + 2 * G3, y2 = y0 - j2 + 2 * G3, z2 = z0 - k2 + 2 * G3;
+        double x3 = x0 - 1 + 3 * G3, y3 = y0 - 1 + 3 * G3, z3 = z0 - 1 + 3 * G3;
+
+        int ii = i & 255;
+        int jj = j & 255;
+        int kk = k & 255;
+        double n = corner3(p12[ii + p[jj + p[kk]]], x0, y0, z0) +
+                   corner3(p12[ii + i1 + p[jj + j1 + p[kk + k1]]], x1, y1, z1) +
+                   corner3(p12[ii + i2 + p[jj + j2 + p[kk + k2]]], x2, y2, z2) +
+                   corner3(p12[ii + 1 + p[jj + 1 + p[kk + 1]]], x3, y3, z3);
+        return (32 * n + 1) * 0.5;
+    }
+
+    double generate(double x, double y, double z) override
+    {
+        return dims == 2 ? simplex2(x, y) : simplex3(x, y, z);
+    }
+
+    // a row of 2d samples at (ox + sx * i, y).
+    // the skewed coordinates move linearly along a row, so each block of the row is anchored at a lattice point
+    // in double, and walked in float from there. the blocks are short enough that the error does not grow with
+    // the row length or the step: measured within 2.5e-6 of #generate (steps 0.001 to 17, rows up to 65536).
+    void simplex2_row(double ox, double sx, double y, int n, float *out, std::vector<int> &h,
+                      std::vector<float> &f) const
+    {
+        // samples far apart gain nothing from walking, so each is located in double.
+        double span = std::fabs(sx) * (1 + F2);
+        int block = span * __SIMPLEX_ROW_BLOCK <= __SIMPLEX_ROW_SPAN ? __SIMPLEX_ROW_BLOCK
+                                                                       : (int)(__SIMPLEX_ROW_SPAN / span) & ~7;
+        if (block == 0)
+            return simplex2_many([&](int i) { return std::make_pair(ox + sx * i, y); }, n, out, h, f);
+
+        h.resize(6 * n);
+        f.resize(3 * n);
+
+        __simplex2_row r;
+        r.du = (float)(sx * (1 + F2));
+        r.dv = (float)(sx * F2);
+        r.dx = (float)sx;
+        for (int b = 0; b < n; b += block)
+        {
+            double bx = ox + sx * b;
+            double s0 = (bx + y) * F2;
+            r.iu = fast_floor(bx + s0);
+            r.iv = fast_floor(y + s0);
+            double t0 = (r.iu + r.iv) * G2;
+            r.bx = (float)(bx - (r.iu - t0));
+            r.by = (float)(y - (r.iv - t0));
+            r.u0 = (float)(bx + s0 - r.iu);
+            r.v0 = (float)(y + s0 - r.iv);
+            r.n = std::min(block, n - b);
+            r.ii = h.data() + 3 * n + b;
+            r.jj = r.ii + n;
+            r.o = r.jj + n;
+            r.x0 = f.data() + b;
+            r.y0 = r.x0 + n;
+            r.i1 = r.y0 + n;
+            __simplex2_row_run(r);
+        }
+
+        int *h0 = h.data(), *h1 = h0 + n, *h2 = h1 + n;
+        const int *ci = h2 + n, *cj = ci + n, *co = cj + n;
+        for (int i = 0; i < n; i++)
+        {
+            int ii = ci[i], jj = cj[i], o = co[i];
+            h0[i] = p[ii + p[jj]];
+            h1[i] = p[ii + o + p[jj + 1 - o]];
+            h2[i] = p[ii + 1 + p[jj + 1]];
+        }
+        __simplex2_batch_run({h0, f.data(), f.data() + n, f.data() + 2 * n, n, out});
+    }
+
+    void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out) override
+    {
+        if (nx <= 0 || ny <= 0 || nz <= 0)
+            return;
+
+        __scratch_lease lease;
+        // 2d noise does not change along z, so only the first slice is computed.
+        int slices = dims == 2 ? 1 : nz;
+        for (int k = 0; k < slices; k++)
+        {
+            double z = origin.z + step.z * k;
+            for (int j = 0; j < ny; j++)
+            {
+                double y = origin.y + step.y * j;
+                float *row = out + ((size_t)k * ny + j) * nx;
+                if (dims == 2)
+                    simplex2_row(origin.x, step.x, y, nx, row, lease.s.i, lease.s.f);
+                else
+                    for (int i = 0; i < nx; i++)
+                        row[i] = (float)simplex3(origin.x + step.x * i, y, z);
+            }
+        }
+
+        size_t slice = (size_t)nx * ny;
+        for (int k = slices; k < nz; k++)
+            std::copy(out, out + slice, out + k * slice);
+    }
+
+    void generate_points(const double *x, const double *y, const double *z, int n, float *out) override
+    {
+        if (dims == 2)
+        {
+            __scratch_lease lease;
+            simplex2_many([&](int i) { return std::make_pair(x[i], y[i]); }, n, out, lease.s.i, lease.s.f);
+        }
+        else
+            for (int i = 0; i < n; i++)
+                out[i] = (float)simplex3(x[i], y[i], z[i]);
+    }
+};
+
+shared<noise> make_perlin(long seed)
+{
+    auto ptr = std::make_shared<__noise_perlin>();
+    ptr->seed = seed;
+    ptr->init();
+    return ptr;
+}
+
+shared<noise> make_simplex2(long seed)
+{
+    auto ptr = std::make_shared<__noise_simplex>();
+    ptr->seed = seed;
+    ptr->dims = 2;
+    ptr->init();
+    return ptr;
+}
+
+shared<noise> make_simplex3(long seed)
+{
+    auto ptr = std::make_shared<__noise_simplex>();
+    ptr->seed = seed;
+    ptr->dims = 3;
+    ptr->init();
+    return ptr;
+}
+
+shared<voronoi> make_voronoi(long seed)
+{
+    auto ptr = std::make_shared<__noise_voronoi>();
+    ptr->seed = seed;
+    return ptr;
+}
+
+struct noise_node
+{
+    enum kind_t
+    {
+        SOURCE,
+        FBM,
+        RIDGED,
+        WARP,
+        REMAP,
+        ADD,
+        MUL,
+        CONST
+    };
+
+    kind_t kind;
+    shared<noise> src;
+    int octaves = 1;
+    double freq = 1, lacunarity = 2, gain = 0.5;
+    shared<noise_node> in[4];
+    double k[4] = {0, 0, 0, 0};
+};
+
+// an instruction of a compiled graph. registers hold one float per sample of a block,
+// frames hold the coordinates (x, y, z) that sources are sampled at.
+struct __noise_op
+{
+    enum code_t
+    {
+        SAMPLE, // dst = src(frame * k0 + k1)
+        SET,    // dst = k0
+        ACC,    // dst += a * k0
+        RIDGE,  // s = (1 - |2a - 1|)^2 * b; b = clamp(2s, 0, 1); dst += s * k0
+        SCALE,  // dst = a * k0
+        REMAP,  // dst = remap a from [k0, k1] to [k2, k3]
+        ADD,    // dst = a + b
+        MUL,    // dst = a * b
+        WARP    // frame_out = frame + (2 * (a, b, c) - 1) * k0
+    };
+
+    code_t code;
+    int dst = -1, a = -1, b = -1, c = -1;
+    int frame = 0, frame_out = 0;
+    noise *src = nullptr;
+    double k[4] = {0, 0, 0, 0};
+};
+
+// lattices of all octaves meet at the origin. shifting each octave a bit hides it.
+static constexpr double __OCTAVE_SHIFT = 37.17;
+
+struct __noise_graph : noise
+{
+    static constexpr int BLOCK = 64;
+
+    shared<noise_node> root;
+    std::vector<__noise_op> ops;
+    int regs = 0, frames = 1, out = -1;
+    std::map<std::pair<noise_node *, int>, int> __compiled;
+
+    int reg()
+    {
+        return regs++;
+    }
+
+    int emit(const __noise_op &op)
+    {
+        ops.push_back(op);
+        return op.dst;
+    }
+
+    int compile_octaves(noise_node *n, int frame)
+    {
+        int dst = reg(), tmp = reg(), weight = -1;
+        __noise_op set{__noise_op::SET};
+        set.dst = dst;
+        emit(set);
+        if (n->kind == noise_node::RIDGED)
+        {
+            weight = reg();
+            set.dst = weight;
+            set.k[0] = 1;
+            emit(set);
+        }
+
+        double freq = n->freq, amp = 1, amp_sum = 0;
+        for (int i = 0; i < n->octaves; i++)
+        {
+            __noise_op smp{__noise_op::SAMPLE};
+            smp.dst = tmp;
+            smp.frame = frame;
+            smp.src = n->src.get();
+            smp.k[0] = freq;
+            smp.k[1] = i * __OCTAVE_SHIFT;
+            emit(smp);
+
+            __noise_op acc{n->kind == noise_node::RIDGED ? __noise_op::RIDGE : __noise_op::ACC};
+            acc.dst = dst;
+            acc.a = tmp;
+            acc.b = weight;
+            acc.k[0] = amp;
+            emit(acc);
+
+            amp_sum += amp;
+            freq *= n->lacunarity;
+            amp *= n->gain;
+        }
+
+        __noise_op scale{__noise_op::SCALE};
+        scale.dst = scale.a = dst;
+        scale.k[0] = amp_sum > 0 ? 1 / amp_sum : 0;
+        return emit(scale);
+    }
+
+    int compile(noise_node *n, int frame)
+    {
+        if (!n)
+            prtlog_throw(FX_FATAL, "null node in a noise graph.");
+
+        auto key = std::make_pair(n, frame);
+        auto it = __compiled.find(key);
+        if (it != __compiled.end())
+            return it->second;
+
+        int dst = -1;
+        switch (n->kind)
+        {
+        case noise_node::SOURCE: {
+            __noise_op op{__noise_op::SAMPLE};
+            op.dst = reg();
+            op.frame = frame;
+            op.src = n->src.get();
+            op.k[0] = n->freq;
+            dst = emit(op);
+            break;
+        }
+        case noise_node::FBM:
+        case noise_node::RIDGED:
+            dst = compile_octaves(n, frame);
+            break;
+        case noise_node::WARP: {
+            __noise_op op{__noise_op::WARP};
+            op.a = compile(n->in[1].get(), frame);
+            op.b = compile(n->in[2].get(), frame);
+            op.c = n->in[3] ? compile(n->in[3].get(), frame) : -1;
+            op.frame = frame;
+            op.frame_out = frames++;
+            op.k[0] = n->k[0];
+            emit(op);
+            dst = compile(n->in[0].get(), op.frame_out);
+            break;
+        }
+        case noise_node::REMAP: {
+            __noise_op op{__noise_op::REMAP};
+            op.a = compile(n->in[0].get(), frame);
+            op.dst = reg();
+            std::copy(n->k, n->k + 4, op.k);
+            dst = emit(op);
+            break;
+        }
+        case noise_node::ADD:
+        case noise_node::MUL: {
+            __noise_op op{n->kind == noise_node::ADD ? __noise_op::ADD : __noise_op::MUL};
+            op.a = compile(n->in[0].get(), frame);
+            op.b = compile(n->in[1].get(), frame);
+            op.dst = reg();
+            dst = emit(op);
+            break;
+        }
+        case noise_node::CONST: {
+            __noise_op op{__noise_op::SET};
+            op.dst = reg();
+            op.k[0] = n->k[0];
+            dst = emit(op);
+            break;
+        }
+        }
+
+        __compiled[key] = dst;
+        return dst;
+    }
+
+    // run the program over #n (<= BLOCK) samples, whose coordinates are already in frame 0.
+    void run(std::vector<float> &r, std::vector<double> &f, int n, float *dst)
+    {
+        auto R = [&](int i) { return r.data() + (size_t)i * BLOCK; };
+        auto F = [&](int i, int axis) { return f.data() + ((size_t)i * 3 + axis) * BLOCK; };
+        // the scaled coordinates of a sample op, in the frame after the last one.
+        double *sx = F(frames, 0), *sy = F(frames, 1), *sz = F(frames, 2);
+
+        for (const __noise_op &op : ops)
+        {
+            float *d = op.dst >= 0 ? R(op.dst) : nullptr;
+            const float *a = op.a >= 0 ? R(op.a) : nullptr;
+            float *b = op.b >= 0 ? R(op.b) : nullptr;
+            const float *c = op.c >= 0 ? R(op.c) : nullptr;
+            const float k0 = (float)op.k[0];
+
+            switch (op.code)
+            {
+            case __noise_op::SAMPLE: {
+                const double *x = F(op.frame, 0), *y = F(op.frame, 1), *z = F(op.frame, 2);
+                for (int i = 0; i < n; i++)
+                {
+                    sx[i] = x[i] * op.k[0] + op.k[1];
+                    sy[i] = y[i] * op.k[0] + op.k[1];
+                    sz[i] = z[i] * op.k[0] + op.k[1];
+                }
+                op.src->generate_points(sx, sy, sz, n, d);
+                break;
+            }
+            case __noise_op::SET:
+                std::fill(d, d + n, k0);
+                break;
+            case __noise_op::ACC:
+                for (int i = 0; i < n; i++)
+                    d[i] += a[i] * k0;
+                break;
+            case __noise_op::RIDGE:
+                for (int i = 0; i < n; i++)
+                {
+                    float s = 1 - std::abs(2 * a[i] - 1);
+                    s = s * s * b[i];
+                    b[i] = std::clamp(s * 2, 0.0f, 1.0f);
+                    d[i] += s * k0;
+                }
+                break;
+            case __noise_op::SCALE:
+                for (int i = 0; i < n; i++)
+                    d[i] = a[i] * k0;
+                break;
+            case __noise_op::REMAP: {
+                float from = (float)op.k[0], to = (float)op.k[2];
+                float span = op.k[1] == op.k[0] ? 0 : (float)((op.k[3] - op.k[2]) / (op.k[1] - op.k[0]));
+                float lo = (float)std::min(op.k[2], op.k[3]), hi = (float)std::max(op.k[2], op.k[3]);
+                for (int i = 0; i < n; i++)
+                    d[i] = std::clamp(to + (a[i] - from) * span, lo, hi);
+                break;
+            }
+            case __noise_op::ADD:
+                for (int i = 0; i < n; i++)
+                    d[i] = a[i] + b[i];
+                break;
+            case __noise_op::MUL:
+                for (int i = 0; i < n; i++)
+                    d[i] = a[i] * b[i];
+                break;
+            case __noise_op::WARP: {
+                const double amp = op.k[0];
+                for (int i = 0; i < n; i++)
+                {
+                    F(op.frame_out, 0)[i] = F(op.frame, 0)[i] + (2.0 * a[i] - 1) * amp;
+                    F(op.frame_out, 1)[i] = F(op.frame, 1)[i] + (2.0 * b[i] - 1) * amp;
+                    F(op.frame_out, 2)[i] = F(op.frame, 2)[i] + (c ? (2.0 * c[i] - 1) * amp : 0);
+                }
+                break;
+            }
+            }
+        }
+
+        std::copy(R(out), R(out) + n, dst);
+    }
+
+    // size the registers & frames of one call. it is small (a few kilobytes), and taken from a #__scratch_lease,
+    // so calls from several threads (or nested graphs) never share it.
+    void scratch(std::vector<float> &r, std::vector<double> &f)
+    {
+        r.resize((size_t)regs * BLOCK);
+        f.resize((size_t)(frames + 1) * 3 * BLOCK);
+    }
+
+    double generate(double x, double y, double z) override
+    {
+        float v;
+        generate_points(&x, &y, &z, 1, &v);
+        return v;
+    }
+
+    void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *dst) override
+    {
+        __scratch_lease lease;
+        std::vector<float> &r = lease.s.f;
+        std::vector<double> &f = lease.s.d;
+        scratch(r, f);
+        double *fx = f.data(), *fy = fx + BLOCK, *fz = fy + BLOCK;
+
+        for (int k = 0; k < nz; k++)
+            for (int j = 0; j < ny; j++)
+                for (int i0 = 0; i0 < nx; i0 += BLOCK)
+                {
+                    int n = std::min(BLOCK, nx - i0);
+                    for (int i = 0; i < n; i++)
+                    {
+                        fx[i] = origin.x + step.x * (i0 + i);
+                        fy[i] = origin.y + step.y * j;
+                        fz[i] = origin.z + step.z * k;
+                    }
+                    run(r, f, n, dst + ((size_t)k * ny + j) * nx + i0);
+                }
+    }
+
+    void generate_points(const double *x, const double *y, const double *z, int n, float *dst) override
+    {
+        __scratch_lease lease;
+        std::vector<float> &r = lease.s.f;
+        std::vector<double> &f = lease.s.d;
+        scratch(r, f);
+
+        for (int i0 = 0; i0 < n; i0 += BLOCK)
+        {
+            int m = std::min(BLOCK, n - i0);
+            std::copy(x + i0, x + i0 + m, f.data());
+            std::copy(y + i0, y + i0 + m, f.data() + BLOCK);
+            std::copy(z + i0, z + i0 + m, f.data() + 2 * BLOCK);
+            run(r, f, m, dst + i0);
+        }
+    }
+};
+
+static shared<noise_node> __make_node(noise_node::kind_t kind)
+{
+    auto ptr = std::make_shared<noise_node>();
+    ptr->kind = kind;
+    return ptr;
+}
+
+shared<noise_node> noise_source(shared<noise> src, double freq)
+{
+    auto ptr = __make_node(noise_node::SOURCE);
+    ptr->src = src;
+    ptr->freq = freq;
+    return ptr;
+}
+
+shared<noise_node> noise_fbm(shared<noise> src, int octaves, double freq, double lacunarity, double gain)
+{
+    if (octaves < 1)
+        prtlog_throw(FX_FATAL, "a fractal noise needs at least 1 octave.");
+    auto ptr = __make_node(noise_node::FBM);
+    ptr->src = src;
+    ptr->octaves = octaves;
+    ptr->freq = freq;
+    ptr->lacunarity = lacunarity;
+    ptr->gain = gain;
+    return ptr;
+}
+
+shared<noise_node> noise_ridged(shared<noise> src, int octaves, double freq, double lacunarity, double gain)
+{
+    auto ptr = noise_fbm(src, octaves, freq, lacunarity, gain);
+    ptr->kind = noise_node::RIDGED;
+    return ptr;
+}
+
+shared<noise_node> noise_warp(shared<noise_node> in, shared<noise_node> wx, shared<noise_node> wy,
+                              shared<noise_node> wz, double amp)
+{
+    auto ptr = __make_node(noise_node::WARP);
+    ptr->in[0] = in;
+    ptr->in[1] = wx;
+    ptr->in[2] = wy;
+    ptr->in[3] = wz;
+    ptr->k[0] = amp;
+    return ptr;
+}
+
+shared<noise_node> noise_remap(shared<noise_node> in, double from_min, double from_max, double to_min, double to_max)
+{
+    auto ptr = __make_node(noise_node::REMAP);
+    ptr->in[0] = in;
+    ptr->k[0] = from_min;
+    ptr->k[1] = from_max;
+    ptr->k[2] = to_min;
+    ptr->k[3] = to_max;
+    return ptr;
+}
+
+shared<noise_node> noise_add(shared<noise_node> a, shared<noise_node> b)
+{
+    auto ptr = __make_node(noise_node::ADD);
+    ptr->in[0] = a;
+    ptr->in[1] = b;
+    return ptr;
+}
+
+shared<noise_node> noise_mul(shared<noise_node> a, shared<noise_node> b)
+{
+    auto ptr = __make_node(noise_node::MUL);
+    ptr->in[0] = a;
+    ptr->in[1] = b;
+    return ptr;
+}
+
+shared<noise_node> noise_const(double v)
+{
+    auto ptr = __make_node(noise_node::CONST);
+    ptr->k[0] = v;
+    return ptr;
+}
+
+shared<noise> make_noise_graph(shared<noise_node> root)
+{
+    auto ptr = std::make_shared<__noise_graph>();
+    ptr->seed = 0;
+    // the graph keeps its nodes (and so its sources) alive.
+    ptr->root = root;
+    ptr->out = ptr->compile(root.get(), 0);
+    ptr->__compiled.clear();
+    return ptr;
+}
+
+struct __noise_cache : noise
+{
+    static constexpr int SHARDS = 16;
+
+    struct tile_key
+    {
+        long long tx, ty;
+        double z;
+
+        bool operator==(const tile_key &o) const
+        {
+            return tx == o.tx && ty == o.ty && z == o.z;
+        }
+    };
+
+    struct tile_hash
+    {
+        size_t operator()(const tile_key &k) const
+        {
+            uint64_t h = (uint64_t)k.tx * 0x9E3779B97F4A7C15ULL ^ (uint64_t)k.ty * 0xC2B2AE3D27D4EB4FULL ^
+                         std::hash<double>()(k.z);
+            return (size_t)(h ^ (h >> 29));
+        }
+    };
+
+    using tile_data = shared<const std::vector<float>>;
+
+    struct shard
+    {
+        std::mutex mtx;
+        // front is the most recently used.
+        std::list<std::pair<tile_key, tile_data>> lru;
+        std::unordered_map<tile_key, decltype(lru)::iterator, tile_hash> index;
+        // the caps of the shards add up to #max_tiles. a shard of cap 0 keeps nothing.
+        size_t cap = 0;
+    };
+
+    shared<noise> src;
+    double cell = 1;
+    int tile = 32;
+    shard shards[SHARDS];
+
+    // the lattice index of #v, if it is on the lattice. only the rounding of v / cell is forgiven,
+    // a point any further off is not the lattice point, so it goes to the source.
+    bool on_lattice(double v, long long &idx) const
+    {
+        double f = v / cell;
+        idx = std::llround(f);
+        return std::abs(f - idx) <= 4 * DBL_EPSILON * std::max(std::abs(f), 1.0);
+    }
+
+    static long long floor_div(long long a, long long b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    tile_data fetch(long long tx, long long ty, double z)
+    {
+        tile_key key{tx, ty, z};
+        shard &sh = shards[tile_hash()(key) % SHARDS];
+        {
+            std::lock_guard<std::mutex> lk(sh.mtx);
+            auto it = sh.index.find(key);
+            if (it != sh.index.end())
+            {
+                sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+                return it->second->second;
+            }
+        }
+
+        // computed outside the lock. two threads may compute the same tile at once, the first one is kept.
+        // tiles come from the grid path of #src, so a cached point is as close to #src's #generate as its grids are.
+        auto data = std::make_shared<std::vector<float>>((size_t)tile * tile);
+        double span = tile * cell;
+        src->generate_grid(vec3(tx * span, ty * span, z), vec3(cell, cell, 1), tile, tile, 1, data->data());
+
+        std::lock_guard<std::mutex> lk(sh.mtx);
+        auto it = sh.index.find(key);
+        if (it != sh.index.end())
+            return it->second->second;
+        sh.lru.push_front({key, data});
+        sh.index[key] = sh.lru.begin();
+        while (sh.lru.size() > sh.cap)
+        {
+            sh.index.erase(sh.lru.back().first);
+            sh.lru.pop_back();
+        }
+        return data;
+    }
+
+    double generate(double x, double y, double z) override
+    {
+        long long i, j;
+        if (!on_lattice(x, i) || !on_lattice(y, j))
+            return src->generate(x, y, z);
+        long long tx = floor_div(i, tile), ty = floor_div(j, tile);
+        tile_data t = fetch(tx, ty, z);
+        return (*t)[(j - ty * tile) * tile + (i - tx * tile)];
+    }
+
+    void generate_grid(const vec3 &origin, const vec3 &step, int nx, int ny, int nz, float *out) override
+    {
+        long long i0, j0;
+        if (std::abs(step.x - cell) > cell * 4 * DBL_EPSILON || std::abs(step.y - cell) > cell * 4 * DBL_EPSILON ||
+            !on_lattice(origin.x, i0) || !on_lattice(origin.y, j0))
+        {
+            src->generate_grid(origin, step, nx, ny, nz, out);
+            return;
+        }
+        if (nx <= 0 || ny <= 0 || nz <= 0)
+            return;
+
+        long long tx0 = floor_div(i0, tile), tx1 = floor_div(i0 + nx - 1, tile);
+        long long ty0 = floor_div(j0, tile), ty1 = floor_div(j0 + ny - 1, tile);
+        for (int k = 0; k < nz; k++)
+        {
+            double z = origin.z + step.z * k;
+            float *slice = out + (size_t)k * nx * ny;
+            for (long long ty = ty0; ty <= ty1; ty++)
+                for (long long tx = tx0; tx <= tx1; tx++)
+                {
+                    tile_data t = fetch(tx, ty, z);
+                    // the part of the tile inside the grid, in lattice indices.
+                    long long ia = std::max(i0, tx * tile), ib = std::min(i0 + nx, (tx + 1) * tile);
+                    long long ja = std::max(j0, ty * tile), jb = std::min(j0 + ny, (ty + 1) * tile);
+                    for (long long j = ja; j < jb; j++)
+                    {
+                        const float *from = t->data() + (j - ty * tile) * tile + (ia - tx * tile);
+                        std::copy(from, from + (ib - ia), slice + (j - j0) * nx + (ia - i0));
+                    }
+                }
+        }
+    }
+};
+
+shared<noise> make_noise_cache(shared<noise> src, double cell, int tile, int max_tiles)
+{
+    auto ptr = std::make_shared<__noise_cache>();
+    ptr->seed = src->seed;
+    ptr->src = src;
+    ptr->cell = cell;
+    ptr->tile = std::max(tile, 1);
+    size_t total = std::max(max_tiles, 0);
+    for (size_t i = 0; i < __noise_cache::SHARDS; i++)
+        ptr->shards[i].cap = total / __noise_cache::SHARDS + (i < total % __noise_cache::SHARDS ? 1 : 0);
+    return ptr;
+}
+
+} // namespace flux
@@ -0,0 +1,147 @@
+#include <core/pool.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace flux
+{
+
+struct thread_pool::_impl
+{
+    struct job_queue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<unique<job_queue>> queues;
+    // sleeping workers wait on it. #queued only grows under #mtx, so a wakeup is never lost.
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::atomic<int> queued = 0;
+    std::atomic<unsigned> next = 0;
+    bool is_term = false;
+
+    // the pool & the queue index of the calling worker thread.
+    static thread_local _impl *__tl_pool;
+    static thread_local int __tl_index;
+
+    bool __pop(int idx, std::function<void()> &job)
+    {
+        job_queue &q = *queues[idx];
+        std::lock_guard<std::mutex> lk(q.mtx);
+        if (q.jobs.empty())
+            return false;
+        job = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        return true;
+    }
+
+    // steal from the back, away from where the owner is working.
+    bool __steal(int idx, std::function<void()> &job)
+    {
+        job_queue &q = *queues[idx];
+        std::lock_guard<std::mutex> lk(q.mtx);
+        if (q.jobs.empty())
+            return false;
+        job = std::move(q.jobs.back());
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool __find(int idx, std::function<void()> &job)
+    {
+        if (__pop(idx, job))
+            return true;
+        int n = (int)queues.size();
+        for (int i = 1; i < n; i++)
+            if (__steal((idx + i) % n, job))
+                return true;
+        return false;
+    }
+
+    void __work(int idx)
+    {
+        __tl_pool = this;
+        __tl_index = idx;
+
+        while (true)
+        {
+            std::function<void()> job;
+            if (__find(idx, job))
+            {
+                queued--;
+                job();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [this] { return is_term || queued > 0; });
+            // queued jobs are still drained before the workers quit.
+            if (is_term && queued == 0)
+                return;
+        }
+    }
+};
+
+thread_local thread_pool::_impl *thread_pool::_impl::__tl_pool = nullptr;
+thread_local int thread_pool::_impl::__tl_index = -1;
+
+thread_pool::thread_pool(int threads) : __p(std::make_unique<_impl>())
+{
+    int n = std::max(threads, 1);
+    for (int i = 0; i < n; i++)
+        __p->queues.push_back(std::make_unique<_impl::job_queue>());
+    for (int i = 0; i < n; i++)
+        __p->workers.emplace_back([this, i] { __p->__work(i); });
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lk(__p->mtx);
+        __p->is_term = true;
+    }
+    __p->cv.notify_all();
+    for (auto &t : __p->workers)
+        t.join();
+}
+
+void thread_pool::submit(std::function<void()> job)
+{
+    int idx = _impl::__tl_pool == __p.get() ? _impl::__tl_index
+                                             : (int)(__p->next++ % (unsigned)__p->queues.size());
+    {
+        auto &q = *__p->queues[idx];
+        std::lock_guard<std::mutex> lk(q.mtx);
+        q.jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lk(__p->mtx);
+        __p->queued++;
+    }
+    __p->cv.notify_one();
+}
+
+int thread_pool::size() const
+{
+    return (int)__p->workers.size();
+}
+
+shared<thread_pool> get_gpool()
+{
+    static shared<thread_pool> __gpool = make_pool((int)std::thread::hardware_concurrency() - 1);
+    return __gpool;
+}
+
+shared<thread_pool> make_pool(int threads)
+{
+    return std::make_shared<thread_pool>(threads);
+}
+
+} // namespace flux
@@ -1,24 +1,87 @@
 #include <core/rand.h>
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 namespace flux
 {
 
+static uint64_t __splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t __rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
 struct random::_impl
 {
-    long a, b;
+    uint64_t s[4];
+
+    // expand a seed with splitmix64, as the xoshiro authors recommend. it never yields an all-zero state.
+    void seed(uint64_t v)
+    {
+        for (auto &w : s)
+            w = __splitmix64(v);
+    }
+
+    inline uint64_t next()
+    {
+        uint64_t result = __rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = __rotl(s[3], 45);
+        return result;
+    }
+
+    // the top 53 bits, scaled into [0, 1).
+    inline double next_double()
+    {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    // lemire's multiply-shift, with rejection to stay unbiased.
+    inline uint32_t next_below(uint32_t bound)
+    {
+        uint64_t m = (uint64_t)(uint32_t)(next() >> 32) * bound;
+        uint32_t l = (uint32_t)m;
+        if (l < bound)
+        {
+            uint32_t t = (0u - bound) % bound;
+            while (l < t)
+            {
+                m = (uint64_t)(uint32_t)(next() >> 32) * bound;
+                l = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
 };
 
 random::random() : __p(std::make_unique<_impl>())
 {
+    __p->seed(0);
 }
 
 random::~random() = default;
 
 void random::set_seed(long seed)
 {
-    __p->a = (seed + 13) / 2;
-    __p->b = (seed - 9) ^ 39;
+    __p->seed((uint64_t)seed);
+}
+
+void random::set_seed_bits(uint64_t seed)
+{
+    __p->seed(seed);
 }
 
 bool random::next_bool()
@@ -28,9 +91,7 @@ bool random::next_bool()
 
 double random::next()
 {
-    static std::mt19937_64 rng{std::random_device{}()};
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-    return dist(rng);
+    return __p->next_double();
 }
 
 double random::next(double min, double max)
@@ -54,9 +115,9 @@ double random::next_guassian(double min, double max)
 
 int random::next_int(int bound)
 {
-    static std::mt19937_64 rng{std::random_device{}()};
-    std::uniform_int_distribution<int> dist(0, bound - 1);
-    return dist(rng);
+    if (bound <= 0)
+        return 0;
+    return (int)__p->next_below((uint32_t)bound);
 }
 
 int random::next_int(int min, int max)
@@ -64,217 +125,109 @@ int random::next_int(int min, int max)
     return next_int(max + 1 - min) + min;
 }
 
-void random::write(byte_buf &buf)
+uint64_t random::next_bits()
 {
-    buf.write<long>(__p->a);
-    buf.write<long>(__p->b);
+    return __p->next();
 }
 
-void random::read(byte_buf &buf)
+void random::next_many(double *out, int n)
 {
-    __p->a = buf.read<long>();
-    __p->b = buf.read<long>();
+    // work on a local copy, so the state stays in registers through the loop.
+    _impl st = *__p;
+    for (int i = 0; i < n; i++)
+        out[i] = st.next_double();
+    *__p = st;
 }
 
-shared<random> random::copy()
+void random::next_int_many(int *out, int n, int bound)
 {
-    return copy(0);
+    if (bound <= 0)
+    {
+        std::fill(out, out + n, 0);
+        return;
+    }
+    _impl st = *__p;
+    for (int i = 0; i < n; i++)
+        out[i] = (int)st.next_below((uint32_t)bound);
+    *__p = st;
 }
 
-shared<random> random::copy(int seed_addon)
+void random::jump()
 {
-    auto ptr = std::make_shared<random>();
-    ptr->__p->a = __p->a + seed_addon;
-    ptr->__p->b = __p->b - seed_addon;
-    return ptr;
-}
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+                                    0x39abdc4529b1661cULL};
 
-shared<random> __grand = make_random();
+    uint64_t t[4] = {0, 0, 0, 0};
+    for (uint64_t j : JUMP)
+        for (int b = 0; b < 64; b++)
+        {
+            if (j & (1ULL << b))
+                for (int i = 0; i < 4; i++)
+                    t[i] ^= __p->s[i];
+            __p->next();
+        }
+    for (int i = 0; i < 4; i++)
+        __p->s[i] = t[i];
+}
 
-shared<random> get_grand()
+shared<random> random::split()
 {
-    return __grand;
+    auto ptr = copy();
+    jump();
+    return ptr;
 }
 
-shared<random> make_random()
+void random::write(byte_buf &buf)
 {
-    static std::mt19937_64 rng{std::random_device{}()};
-    std::uniform_int_distribution<int> dist(0, INT_MAX);
-    return make_random(dist(rng));
+    for (uint64_t w : __p->s)
+        buf.write<uint64_t>(w);
 }
 
-shared<random> make_random(long seed)
+void random::read(byte_buf &buf)
 {
-    auto ptr = std::make_shared<random>();
-    ptr->set_seed(seed);
-    return ptr;
+    for (uint64_t &w : __p->s)
+        w = buf.read<uint64_t>();
 }
 
-struct __noise_perlin : noise
+shared<random> random::copy()
 {
-    int p[512];
-
-    void init()
-    {
-        auto rd = make_random(seed);
-
-        int perm[256];
-        for (int i = 0; i < 256; i++)
-        {
-            perm[i] = i;
-        }
-
-        for (int i = 255; i > 0; i--)
-        {
-            int j = rd->next_int(i + 1);
-            int temp = perm[i];
-            perm[i] = perm[j];
-            perm[j] = temp;
-        }
-
-        for (int i = 0; i < 256; i++)
-        {
-            p[i] = p[i + 256] = perm[i];
-        }
-    }
-
-    inline int fast_floor(double x) const
-    {
-        int xi = (int)x;
-        return x < xi ? xi - 1 : xi;
-    }
-
-    inline double fade(double t) const
-    {
-        return t * t * t * (t * (t * 6 - 15) + 10);
-    }
-
-    inline double lerp(double t, double a, double b) const
-    {
-        return a + t * (b - a);
-    }
-
-    inline double grad(int hash, double x, double y, double z) const
-    {
-        int h = hash & 15;
-
-        switch (h & 7)
-        {
-        case 0:
-            return x + y;
-        case 1:
-            return -x + y;
-        case 2:
-            return x - y;
-        case 3:
-            return -x - y;
-        case 4:
-            return x + z;
-        case 5:
-            return -x + z;
-        case 6:
-            return x - z;
-        case 7:
-            return -x - z;
-        default:
-            return 0;
-        }
-    }
-
-    double generate(double x, double y, double z) override
-    {
-        int X = fast_floor(x) & 255;
-        int Y = fast_floor(y) & 255;
-        int Z = fast_floor(z) & 255;
-
-        x -= fast_floor(x);
-        y -= fast_floor(y);
-        z -= fast_floor(z);
-
-        double u = fade(x);
-        double v = fade(y);
-        double w = fade(z);
-
-        int A = p[X] + Y;
-        int AA = p[A] + Z;
-        int AB = p[A + 1] + Z;
-        int B = p[X + 1] + Y;
-        int BA = p[B] + Z;
-        int BB = p[B + 1] + Z;
-
-        double result = lerp(w,
-                             lerp(v, lerp(u, grad(p[AA], x, y, z), grad(p[BA], x - 1, y, z)),
-                                  lerp(u, grad(p[AB], x, y - 1, z), grad(p[BB], x - 1, y - 1, z))),
-                             lerp(v, lerp(u, grad(p[AA + 1], x, y, z - 1), grad(p[BA + 1], x - 1, y, z - 1)),
-                                  lerp(u, grad(p[AB + 1], x, y - 1, z - 1), grad(p[BB + 1], x - 1, y - 1, z - 1))));
-
-        return (result + 1.0) * 0.5;
-    }
-};
+    return copy(0);
+}
 
-struct __noise_voronoi : noise
+shared<random> random::copy(int seed_addon)
 {
-    inline int floor(double v)
-    {
-        int i = (int)v;
-        return v >= i ? i : i - 1;
-    }
-
-    inline double seedl(int x, int y, int z, long seed)
+    auto ptr = std::make_shared<random>();
+    *ptr->__p = *__p;
+    if (seed_addon != 0)
     {
-        long v1 = (x + 2687 * y + 433 * z + 941 * seed) & INT_MAX;
-        long v2 = (v1 * (v1 * v1 * 113 + 653) + 2819) & INT_MAX;
-        return 1 - (double)v2 / INT_MAX;
+        // derive a different, but still deterministic, state.
+        uint64_t v = (uint64_t)seed_addon;
+        for (auto &w : ptr->__p->s)
+            w ^= __splitmix64(v);
+        if ((ptr->__p->s[0] | ptr->__p->s[1] | ptr->__p->s[2] | ptr->__p->s[3]) == 0)
+            ptr->__p->seed((uint64_t)seed_addon);
     }
+    return ptr;
+}
 
-    double generate(double x, double y, double z) override
-    {
-        int x0 = floor(x);
-        int y0 = floor(y);
-        int z0 = floor(z);
-
-        double xc = 0;
-        double yc = 0;
-        double zc = 0;
-        double md = INT_MAX;
-
-        for (int k = z0 - 2; k <= z0 + 2; k++)
-            for (int j = y0 - 2; j <= y0 + 2; j++)
-                for (int i = x0 - 2; i <= x0 + 2; i++)
-                {
-                    double xp = i + seedl(i, j, k, seed);
-                    double yp = j + seedl(i, j, k, seed + 1);
-                    double zp = k + seedl(i, j, k, seed + 2);
-                    double xd = xp - x;
-                    double yd = yp - y;
-                    double zd = zp - z;
-                    double d = xd * xd + yd * yd + zd * zd;
-
-                    if (d < md)
-                    {
-                        md = d;
-                        xc = xp;
-                        yc = yp;
-                        zc = zp;
-                    }
-                }
-
-        return seedl(floor(xc), floor(yc), floor(zc), 0);
-    }
-};
+shared<random> get_grand()
+{
+    thread_local shared<random> grand = make_random();
+    return grand;
+}
 
-shared<noise> make_perlin(long seed)
+shared<random> make_random()
 {
-    auto ptr = std::make_shared<__noise_perlin>();
-    ptr->seed = seed;
-    ptr->init();
+    std::random_device rd;
+    auto ptr = std::make_shared<random>();
+    ptr->set_seed_bits(((uint64_t)rd() << 32) | rd());
     return ptr;
 }
 
-shared<noise> make_voronoi(long seed)
+shared<random> make_random(long seed)
 {
-    auto ptr = std::make_shared<__noise_voronoi>();
-    ptr->seed = seed;
+    auto ptr = std::make_shared<random>();
+    ptr->set_seed(seed);
     return ptr;
 }
 
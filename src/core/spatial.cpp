@@ -0,0 +1,742 @@
+#include <core/spatial.h>
+#include <core/log.h>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace flux
+{
+
+static bool __overlap(const quad &a, const quad &b)
+{
+    return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+// handles of removed objects, reused by later inserts.
+struct __spatial_slots
+{
+    std::vector<int> free;
+    int count = 0;
+
+    template <typename O> int take(std::vector<O> &objs)
+    {
+        count++;
+        if (!free.empty())
+        {
+            int h = free.back();
+            free.pop_back();
+            return h;
+        }
+        objs.emplace_back();
+        return (int)objs.size() - 1;
+    }
+
+    void give(int h)
+    {
+        count--;
+        free.push_back(h);
+    }
+};
+
+template <typename O> static void __check_handle(const std::vector<O> &objs, int h)
+{
+    if (h < 0 || h >= (int)objs.size() || !objs[h].alive)
+        prtlog_throw(FX_FATAL, "invalid spatial handle {}.", h);
+}
+
+struct __grid_obj
+{
+    quad box;
+    long user = 0;
+    // the cells touched, inclusive.
+    int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+    bool alive = false;
+    bool big = false;
+};
+
+struct __hash_grid : spatial_index
+{
+    // objects touching more cells go to #bigs.
+    static constexpr int MAX_CELLS = 64;
+
+    double cell;
+    std::vector<__grid_obj> objs;
+    __spatial_slots slots;
+    std::unordered_map<uint64_t, std::vector<int>> cells;
+    std::vector<int> bigs;
+
+    static uint64_t __key(int cx, int cy)
+    {
+        return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+    }
+
+    int __coord(double v) const
+    {
+        // far away coordinates are clamped, the boxes are still tested exactly.
+        return (int)std::clamp(std::floor(v / cell), -1e9, 1e9);
+    }
+
+    void __range(const quad &q, int &x0, int &y0, int &x1, int &y1) const
+    {
+        x0 = __coord(q.x);
+        y0 = __coord(q.y);
+        x1 = __coord(q.x + q.width);
+        y1 = __coord(q.y + q.height);
+    }
+
+    void __link(int h)
+    {
+        __grid_obj &o = objs[h];
+        __range(o.box, o.x0, o.y0, o.x1, o.y1);
+        o.big = (int64_t)(o.x1 - o.x0 + 1) * (o.y1 - o.y0 + 1) > MAX_CELLS;
+        if (o.big)
+        {
+            bigs.push_back(h);
+            return;
+        }
+        for (int cy = o.y0; cy <= o.y1; cy++)
+            for (int cx = o.x0; cx <= o.x1; cx++)
+                cells[__key(cx, cy)].push_back(h);
+    }
+
+    static void __erase(std::vector<int> &v, int h)
+    {
+        auto it = std::find(v.begin(), v.end(), h);
+        *it = v.back();
+        v.pop_back();
+    }
+
+    void __unlink(int h)
+    {
+        __grid_obj &o = objs[h];
+        if (o.big)
+        {
+            __erase(bigs, h);
+            return;
+        }
+        for (int cy = o.y0; cy <= o.y1; cy++)
+            for (int cx = o.x0; cx <= o.x1; cx++)
+            {
+                auto it = cells.find(__key(cx, cy));
+                __erase(it->second, h);
+                if (it->second.empty())
+                    cells.erase(it);
+            }
+    }
+
+    int insert(const quad &box, long user) override
+    {
+        int h = slots.take(objs);
+        objs[h].box = box;
+        objs[h].user = user;
+        objs[h].alive = true;
+        __link(h);
+        return h;
+    }
+
+    void move(int h, const quad &box) override
+    {
+        __check_handle(objs, h);
+        __grid_obj &o = objs[h];
+        int x0, y0, x1, y1;
+        __range(box, x0, y0, x1, y1);
+        // the common case: a small step inside the same cells.
+        if (x0 == o.x0 && y0 == o.y0 && x1 == o.x1 && y1 == o.y1)
+        {
+            o.box = box;
+            return;
+        }
+        __unlink(h);
+        o.box = box;
+        __link(h);
+    }
+
+    void remove(int h) override
+    {
+        __check_handle(objs, h);
+        __unlink(h);
+        objs[h].alive = false;
+        slots.give(h);
+    }
+
+    void clear() override
+    {
+        objs.clear();
+        slots = {};
+        cells.clear();
+        bigs.clear();
+    }
+
+    int query(const quad &region, int *out, int cap) const override
+    {
+        int rx0, ry0, rx1, ry1;
+        __range(region, rx0, ry0, rx1, ry1);
+        int n = 0;
+
+        // an object touching several cells of the region is reported only in the first of them,
+        // i.e. the one at the max of both lower corners. so no set of visited objects is needed.
+        auto visit = [&](int cx, int cy, const std::vector<int> &list) {
+            for (int h : list)
+            {
+                const __grid_obj &o = objs[h];
+                if (std::max(o.x0, rx0) != cx || std::max(o.y0, ry0) != cy || !__overlap(o.box, region))
+                    continue;
+                if (n < cap)
+                    out[n] = h;
+                n++;
+            }
+        };
+
+        // a large region walks the occupied cells rather than the empty ones.
+        if ((double)(rx1 - rx0 + 1) * (ry1 - ry0 + 1) <= (double)cells.size())
+        {
+            for (int cy = ry0; cy <= ry1; cy++)
+                for (int cx = rx0; cx <= rx1; cx++)
+                {
+                    auto it = cells.find(__key(cx, cy));
+                    if (it != cells.end())
+                        visit(cx, cy, it->second);
+                }
+        }
+        else
+        {
+            for (auto &[k, list] : cells)
+            {
+                int cx = (int)(uint32_t)(k >> 32), cy = (int)(uint32_t)k;
+                if (cx >= rx0 && cx <= rx1 && cy >= ry0 && cy <= ry1)
+                    visit(cx, cy, list);
+            }
+        }
+
+        for (int h : bigs)
+        {
+            if (!__overlap(objs[h].box, region))
+                continue;
+            if (n < cap)
+                out[n] = h;
+            n++;
+        }
+        return n;
+    }
+
+    int query_point(const vec2 &p, int *out, int cap) const override
+    {
+        return query(quad(p.x, p.y, 0, 0), out, cap);
+    }
+
+    quad box_of(int h) const override
+    {
+        __check_handle(objs, h);
+        return objs[h].box;
+    }
+
+    long user_of(int h) const override
+    {
+        __check_handle(objs, h);
+        return objs[h].user;
+    }
+
+    int size() const override
+    {
+        return slots.count;
+    }
+};
+
+shared<spatial_index> make_hash_grid(double cell)
+{
+    if (cell <= 0)
+        prtlog_throw(FX_FATAL, "the cell size of a hash grid must be positive, got {}.", cell);
+    auto p = std::make_shared<__hash_grid>();
+    p->cell = cell;
+    return p;
+}
+
+struct __qt_node
+{
+    quad area;
+    // #area, grown by half of its size on each side.
+    quad loose;
+    int parent = -1;
+    int child[4] = {-1, -1, -1, -1};
+    std::vector<int> objs;
+    // objects in this node & all below it, so empty branches are skipped.
+    int total = 0;
+};
+
+struct __qt_obj
+{
+    quad box;
+    long user = 0;
+    int node = -1;
+    // index in the object list of the node.
+    int at = 0;
+    bool alive = false;
+};
+
+struct __quadtree : spatial_index
+{
+    quad bounds;
+    int max_depth;
+    std::vector<__qt_node> nodes;
+    std::vector<__qt_obj> objs;
+    __spatial_slots slots;
+
+    int __make_node(const quad &area, int parent)
+    {
+        __qt_node n;
+        n.area = area;
+        n.loose = quad(area.x - area.width / 2, area.y - area.height / 2, area.width * 2, area.height * 2);
+        n.parent = parent;
+        nodes.push_back(std::move(n));
+        return (int)nodes.size() - 1;
+    }
+
+    // the node an object belongs to. children are made on the way down.
+    int __place(const quad &box)
+    {
+        if (box.x < bounds.x || box.y < bounds.y || box.prom_x() > bounds.prom_x() || box.prom_y() > bounds.prom_y())
+            return 0;
+
+        int depth = 0;
+        double w = bounds.width, h = bounds.height;
+        while (depth < max_depth && box.width <= w / 2 && box.height <= h / 2)
+        {
+            w /= 2;
+            h /= 2;
+            depth++;
+        }
+
+        double cx = box.center_x(), cy = box.center_y();
+        int node = 0;
+        for (int d = 0; d < depth; d++)
+        {
+            quad a = nodes[node].area;
+            double mx = a.center_x(), my = a.center_y();
+            int q = (cx >= mx ? 1 : 0) | (cy >= my ? 2 : 0);
+            if (nodes[node].child[q] < 0)
+            {
+                double hw = a.width / 2, hh = a.height / 2;
+                quad ca(q & 1 ? mx : a.x, q & 2 ? my : a.y, hw, hh);
+                int c = __make_node(ca, node);
+                nodes[node].child[q] = c;
+            }
+            node = nodes[node].child[q];
+        }
+        return node;
+    }
+
+    void __link(int h, int node)
+    {
+        __qt_obj &o = objs[h];
+        o.node = node;
+        o.at = (int)nodes[node].objs.size();
+        nodes[node].objs.push_back(h);
+        for (int n = node; n >= 0; n = nodes[n].parent)
+            nodes[n].total++;
+    }
+
+    void __unlink(int h)
+    {
+        __qt_obj &o = objs[h];
+        std::vector<int> &list = nodes[o.node].objs;
+        int last = list.back();
+        list[o.at] = last;
+        objs[last].at = o.at;
+        list.pop_back();
+        for (int n = o.node; n >= 0; n = nodes[n].parent)
+            nodes[n].total--;
+        o.node = -1;
+    }
+
+    int insert(const quad &box, long user) override
+    {
+        int h = slots.take(objs);
+        objs[h].box = box;
+        objs[h].user = user;
+        objs[h].alive = true;
+        __link(h, __place(box));
+        return h;
+    }
+
+    void move(int h, const quad &box) override
+    {
+        __check_handle(objs, h);
+        int node = __place(box);
+        objs[h].box = box;
+        if (node == objs[h].node)
+            return;
+        __unlink(h);
+        __link(h, node);
+    }
+
+    void remove(int h) override
+    {
+        __check_handle(objs, h);
+        __unlink(h);
+        objs[h].alive = false;
+        slots.give(h);
+    }
+
+    void clear() override
+    {
+        nodes.clear();
+        objs.clear();
+        slots = {};
+        __make_node(bounds, -1);
+    }
+
+    int query(const quad &region, int *out, int cap) const override
+    {
+        int n = 0;
+        int stack[64 * 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const __qt_node &node = nodes[stack[--top]];
+            // the root also holds the objects out of bounds, so it is always visited.
+            if (node.parent >= 0 && !__overlap(node.loose, region))
+                continue;
+            for (int h : node.objs)
+            {
+                if (!__overlap(objs[h].box, region))
+                    continue;
+                if (n < cap)
+                    out[n] = h;
+                n++;
+            }
+            for (int c : node.child)
+                if (c >= 0 && nodes[c].total > 0)
+                    stack[top++] = c;
+        }
+        return n;
+    }
+
+    int query_point(const vec2 &p, int *out, int cap) const override
+    {
+        return query(quad(p.x, p.y, 0, 0), out, cap);
+    }
+
+    quad box_of(int h) const override
+    {
+        __check_handle(objs, h);
+        return objs[h].box;
+    }
+
+    long user_of(int h) const override
+    {
+        __check_handle(objs, h);
+        return objs[h].user;
+    }
+
+    int size() const override
+    {
+        return slots.count;
+    }
+};
+
+shared<spatial_index> make_quadtree(const quad &bounds, int max_depth)
+{
+    if (bounds.width <= 0 || bounds.height <= 0)
+        prtlog_throw(FX_FATAL, "the bounds of a quadtree must not be empty.");
+    auto p = std::make_shared<__quadtree>();
+    p->bounds = bounds;
+    // a deeper tree needs a larger query stack.
+    p->max_depth = std::clamp(max_depth, 0, 60);
+    p->clear();
+    return p;
+}
+
+struct __sap_obj
+{
+    quad box;
+    long user = 0;
+    // still true while dying, so the handle can be read in the end events.
+    bool alive = false;
+    // removed, and waiting for #update to end its pairs.
+    bool dying = false;
+    // inserted, and waiting for #update to merge it into the axes.
+    bool fresh = false;
+};
+
+struct __sap_point
+{
+    double v;
+    int h;
+    // 0 for the lower end, 1 for the upper end. lower ends sort first on ties, so touching boxes intersect.
+    int upper;
+
+    bool operator<(const __sap_point &o) const
+    {
+        return v < o.v || (v == o.v && upper < o.upper);
+    }
+};
+
+struct sweep_prune::_impl
+{
+    static constexpr uint8_t NOW = 1, REPORTED = 2, TOUCHED = 4;
+
+    std::vector<__sap_obj> objs;
+    __spatial_slots slots;
+    // inserted since the last update, not in #axis yet.
+    std::vector<int> fresh;
+    std::vector<int> dying;
+    std::vector<__sap_point> axis[2];
+    std::unordered_map<uint64_t, uint8_t> pairs;
+    std::vector<uint64_t> touched;
+    // scratch of #__sweep_fresh.
+    std::vector<__sap_point> __ins;
+    std::vector<int> __active_old, __active_new, __pos;
+
+    static uint64_t __key(int a, int b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+    }
+
+    void __touch(uint8_t &f, uint64_t k)
+    {
+        if (!(f & TOUCHED))
+            touched.push_back(k);
+        f |= TOUCHED;
+    }
+
+    void __begin(int a, int b)
+    {
+        if (a == b || !__overlap(objs[a].box, objs[b].box))
+            return;
+        uint64_t k = __key(a, b);
+        uint8_t &f = pairs[k];
+        f |= NOW;
+        __touch(f, k);
+    }
+
+    void __end(int a, int b)
+    {
+        auto it = pairs.find(__key(a, b));
+        if (it == pairs.end())
+            return;
+        it->second &= ~NOW;
+        __touch(it->second, it->first);
+    }
+
+    void __refresh(std::vector<__sap_point> &ps, int a)
+    {
+        for (__sap_point &e : ps)
+        {
+            const quad &b = objs[e.h].box;
+            if (a == 0)
+                e.v = e.upper ? b.x + b.width : b.x;
+            else
+                e.v = e.upper ? b.y + b.height : b.y;
+        }
+    }
+
+    // an insertion sort. each endpoint passing another one of a different kind flips the pair on this axis.
+    // every pair of endpoints out of order is swapped once, towards its final order, so the pairs are right after
+    // both axes are sorted, whichever axis is sorted first.
+    void __sort(std::vector<__sap_point> &ps)
+    {
+        for (size_t i = 1; i < ps.size(); i++)
+        {
+            __sap_point e = ps[i];
+            size_t j = i;
+            while (j > 0 && e < ps[j - 1])
+            {
+                const __sap_point &o = ps[j - 1];
+                if (!e.upper && o.upper)
+                    __begin(e.h, o.h);
+                else if (e.upper && !o.upper)
+                    __end(e.h, o.h);
+                ps[j] = o;
+                j--;
+            }
+            ps[j] = e;
+        }
+    }
+
+    void __drop_dying()
+    {
+        for (auto &[k, f] : pairs)
+            if (objs[(int)(k >> 32)].dying || objs[(int)(uint32_t)k].dying)
+            {
+                f &= ~NOW;
+                __touch(f, k);
+            }
+        for (auto &ps : axis)
+            ps.erase(std::remove_if(ps.begin(), ps.end(), [&](const __sap_point &e) { return objs[e.h].dying; }),
+                     ps.end());
+    }
+
+    // merge fresh objects into the sorted axes. sinking them one by one would cost a pass over an axis for each,
+    // so their pairs are found by a single sweep along x instead.
+    void __merge_fresh()
+    {
+        std::erase_if(fresh, [&](int h) { return objs[h].dying; });
+        if (fresh.empty())
+            return;
+
+        for (int a = 0; a < 2; a++)
+        {
+            __ins.clear();
+            for (int h : fresh)
+            {
+                __ins.push_back({0, h, 0});
+                __ins.push_back({0, h, 1});
+            }
+            __refresh(__ins, a);
+            std::sort(__ins.begin(), __ins.end());
+            std::vector<__sap_point> &ps = axis[a];
+            size_t mid = ps.size();
+            ps.insert(ps.end(), __ins.begin(), __ins.end());
+            std::inplace_merge(ps.begin(), ps.begin() + mid, ps.end());
+        }
+
+        __pos.resize(objs.size());
+        __active_old.clear();
+        __active_new.clear();
+        for (const __sap_point &e : axis[0])
+        {
+            bool is_new = objs[e.h].fresh;
+            std::vector<int> &act = is_new ? __active_new : __active_old;
+            if (e.upper)
+            {
+                int at = __pos[e.h];
+                act[at] = act.back();
+                __pos[act[at]] = at;
+                act.pop_back();
+                continue;
+            }
+            // only pairs with a fresh object are new. the others were kept by the sort.
+            if (is_new)
+                for (int o : __active_old)
+                    __begin(e.h, o);
+            for (int o : __active_new)
+                __begin(e.h, o);
+            __pos[e.h] = (int)act.size();
+            act.push_back(e.h);
+        }
+        for (int h : fresh)
+            objs[h].fresh = false;
+        fresh.clear();
+    }
+};
+
+// a removed handle can still be read until #update frees it, but not changed.
+static void __check_live(const std::vector<__sap_obj> &objs, int h)
+{
+    __check_handle(objs, h);
+    if (objs[h].dying)
+        prtlog_throw(FX_FATAL, "spatial handle {} is removed.", h);
+}
+
+sweep_prune::sweep_prune() : __p(std::make_shared<_impl>())
+{
+}
+
+sweep_prune::~sweep_prune() = default;
+
+int sweep_prune::insert(const quad &box, long user)
+{
+    int h = __p->slots.take(__p->objs);
+    __sap_obj &o = __p->objs[h];
+    o.box = box;
+    o.user = user;
+    o.alive = true;
+    o.dying = false;
+    o.fresh = true;
+    __p->fresh.push_back(h);
+    return h;
+}
+
+void sweep_prune::move(int h, const quad &box)
+{
+    __check_live(__p->objs, h);
+    __p->objs[h].box = box;
+}
+
+void sweep_prune::remove(int h)
+{
+    __check_live(__p->objs, h);
+    __sap_obj &o = __p->objs[h];
+    o.dying = true;
+    __p->dying.push_back(h);
+}
+
+void sweep_prune::update()
+{
+    _impl &p = *__p;
+    if (!p.dying.empty())
+        p.__drop_dying();
+    for (int a = 0; a < 2; a++)
+    {
+        p.__refresh(p.axis[a], a);
+        p.__sort(p.axis[a]);
+    }
+    p.__merge_fresh();
+
+    std::sort(p.touched.begin(), p.touched.end());
+    for (uint64_t k : p.touched)
+    {
+        auto it = p.pairs.find(k);
+        uint8_t &f = it->second;
+        int a = (int)(k >> 32), b = (int)(uint32_t)k;
+        f &= ~_impl::TOUCHED;
+        if ((f & _impl::NOW) && !(f & _impl::REPORTED))
+        {
+            f |= _impl::REPORTED;
+            if (event_on_begin)
+                event_on_begin(a, b);
+        }
+        else if (!(f & _impl::NOW))
+        {
+            bool reported = f & _impl::REPORTED;
+            p.pairs.erase(it);
+            if (reported && event_on_end)
+                event_on_end(a, b);
+        }
+    }
+    p.touched.clear();
+
+    // freed only now, so the handles are still valid in the end events.
+    for (int h : p.dying)
+    {
+        p.objs[h].alive = false;
+        p.objs[h].dying = false;
+        p.objs[h].fresh = false;
+        p.slots.give(h);
+    }
+    p.dying.clear();
+}
+
+bool sweep_prune::overlapping(int a, int b) const
+{
+    auto it = __p->pairs.find(_impl::__key(a, b));
+    return it != __p->pairs.end() && (it->second & _impl::REPORTED);
+}
+
+quad sweep_prune::box_of(int h) const
+{
+    __check_handle(__p->objs, h);
+    return __p->objs[h].box;
+}
+
+long sweep_prune::user_of(int h) const
+{
+    __check_handle(__p->objs, h);
+    return __p->objs[h].user;
+}
+
+int sweep_prune::size() const
+{
+    return __p->slots.count - (int)__p->dying.size();
+}
+
+shared<sweep_prune> make_sweep_prune()
+{
+    return std::make_shared<sweep_prune>();
+}
+
+} // namespace flux
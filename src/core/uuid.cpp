@@ -1,14 +1,14 @@
 #include <core/uuid.h>
 #include <chrono>
+#include <cstring>
 #include <random>
+#include <thread>
 
 namespace flux
 {
 
 bool uuid::operator==(const uuid &other) const
 {
-    if (__hash != other.__hash)
-        return false;
     return bytes == other.bytes;
 }
 
@@ -33,30 +33,74 @@ uuid::operator std::string() const
     return result;
 }
 
+// the finalizer of murmur3, a cheap and good 64-bit mixer.
+static uint64_t __fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+size_t uuid::hash() const
+{
+    uint64_t hi, lo;
+    std::memcpy(&hi, bytes.data(), 8);
+    std::memcpy(&lo, bytes.data() + 8, 8);
+    return (size_t)__fmix64(hi ^ __fmix64(lo));
+}
+
 uuid uuid_null()
 {
     return uuid();
 }
 
-uuid uuid_generate()
+static uint64_t __splitmix64(uint64_t &state)
 {
-    uuid u;
-
-    auto now = std::chrono::high_resolution_clock::now();
-    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-    for (int i = 0; i < 8; i++)
-        u.bytes[i] = (ns >> (56 - i * 8)) & 0xFF;
+uuid uuid_generate()
+{
+    // each thread has its own generator & sequence, so no locks or shared atomics are needed.
+    thread_local uint64_t state = std::random_device{}() ^ ((uint64_t)std::random_device{}() << 32) ^
+                                  std::hash<std::thread::id>{}(std::this_thread::get_id());
+    thread_local uint64_t last_ms = 0;
+    thread_local uint16_t seq = 0;
+
+    uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    if (ms <= last_ms)
+    {
+        // the same millisecond (or the clock went back): count up, and borrow a millisecond on overflow.
+        ms = last_ms;
+        if (++seq > 0x0FFF)
+        {
+            seq = 0;
+            ms++;
+        }
+    }
+    else
+        seq = (uint16_t)(__splitmix64(state) & 0x01FF);
+    last_ms = ms;
 
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<int> dis(0, 255);
+    uuid u;
+    for (int i = 0; i < 6; i++)
+        u.bytes[i] = (ms >> (40 - i * 8)) & 0xFF;
+    u.bytes[6] = 0x70 | ((seq >> 8) & 0x0F);
+    u.bytes[7] = seq & 0xFF;
 
+    uint64_t r = __splitmix64(state);
     for (int i = 8; i < 16; i++)
-        u.bytes[i] = dis(gen);
-
-    u.__hash =
-        std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(u.bytes.data()), u.bytes.size()));
+        u.bytes[i] = (r >> ((15 - i) * 8)) & 0xFF;
+    // variant 10xx
+    u.bytes[8] = 0x80 | (u.bytes[8] & 0x3F);
 
     return u;
 }
@@ -42,6 +42,16 @@ void atlas::end()
 }
 
 shared<texture> atlas::accept(shared<image> image)
+{
+    if (!image || !image->pixels)
+        return nullptr;
+    auto tex = try_accept(image);
+    if (tex == nullptr)
+        prtlog_throw(FX_FATAL, "atlas is not big enough. please expand it.");
+    return tex;
+}
+
+shared<texture> atlas::try_accept(shared<image> image)
 {
     if (!image || !image->pixels)
         return nullptr;
@@ -61,7 +71,7 @@ shared<texture> atlas::accept(shared<image> image)
             bestScore = score, best = (int)i;
     }
     if (best == -1)
-        prtlog_throw(FX_FATAL, "atlas is not big enough. please expand it.");
+        return nullptr;
 
     quad used = free_rects[best];
     int dx = used.x;
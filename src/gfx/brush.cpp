@@ -2,37 +2,23 @@
 #include <gfx/gfx.h>
 #include <gl/glew.h>
 #include <gl/gl.h>
+#include <algorithm>
 #include <memory>
+#include <tuple>
 #include <core/log.h>
 #include <gfx/mesh.h>
 
 namespace flux::gfx
 {
 
-static uint16_t __to_half(float f)
+static vertex_colored __vc(float x, float y, const half *c)
 {
-    union {
-        float f;
-        uint32_t u;
-    } v = {f};
-    uint32_t s = (v.u >> 31) & 0x1;
-    uint32_t e = (v.u >> 23) & 0xFF;
-    uint32_t m = v.u & 0x7FFFFF;
-    if (e == 0xFF)
-        return uint16_t((s << 15) | 0x7C00 | (m ? 1 : 0));
-    if (!e)
-        return uint16_t((s << 15) | (m >> 13));
-    int32_t E = int32_t(e) - 127 + 15;
-    if (E > 31)
-        E = 31;
-    if (E < 0)
-        E = 0;
-    return uint16_t((s << 15) | (E << 10) | (m >> 13));
+    return {x, y, c[0], c[1], c[2], c[3]};
 }
 
-void __w_half(shared<complex_buffer> buf, const color &col)
+static vertex_textured __vt(float x, float y, const half *c, float u, float v)
 {
-    buf->vtx(__to_half(col.r)).vtx(__to_half(col.g)).vtx(__to_half(col.b)).vtx(__to_half(col.a));
+    return {x, y, c[0], c[1], c[2], c[3], u, v};
 }
 
 brush::brush()
@@ -63,6 +49,7 @@ void brush::cl_norm()
 void brush::cl_set(const color &col)
 {
     vertex_color[0] = vertex_color[1] = vertex_color[2] = vertex_color[3] = col;
+    __encode_color();
 }
 
 void brush::cl_mrg(const color &col)
@@ -71,6 +58,7 @@ void brush::cl_mrg(const color &col)
     vertex_color[1] = vertex_color[1] * col;
     vertex_color[2] = vertex_color[2] * col;
     vertex_color[3] = vertex_color[3] * col;
+    __encode_color();
 }
 
 void brush::cl_mrg(double v)
@@ -79,6 +67,20 @@ void brush::cl_mrg(double v)
     vertex_color[1] = vertex_color[1] * v;
     vertex_color[2] = vertex_color[2] * v;
     vertex_color[3] = vertex_color[3] * v;
+    __encode_color();
+}
+
+void brush::__encode_color()
+{
+    float f[16];
+    for (int i = 0; i < 4; i++)
+    {
+        f[i * 4 + 0] = vertex_color[i].r;
+        f[i * 4 + 1] = vertex_color[i].g;
+        f[i * 4 + 2] = vertex_color[i].b;
+        f[i * 4 + 3] = vertex_color[i].a;
+    }
+    to_half_many(f, &__vertex_half[0][0], 16);
 }
 
 void brush::ts_push()
@@ -126,6 +128,7 @@ void brush::ts_rot(const vec2 &v, double r)
 
 void brush::use(const camera &cam)
 {
+    // a queued draw is projected by the camera bound when it is flushed.
     flush();
     camera_binded = cam;
     viewport(cam.viewport);
@@ -135,14 +138,15 @@ void brush::use(shared<shader_program> program)
 {
     if (m_state.program != program)
     {
-        flush();
+        __flush_buffer();
         m_state.program = program;
     }
 }
 
 void brush::use(const graph_state &sts)
 {
-    flush();
+    __flush_buffer();
+    __dstate_stale = true;
     use(m_state.program);
     assert_texture(m_state.texture);
     assert_mode(m_state.mode);
@@ -156,6 +160,13 @@ transform brush::get_combined_transform()
 }
 
 void brush::flush()
+{
+    if (!__queue.empty())
+        __submit();
+    __flush_buffer();
+}
+
+void brush::__flush_buffer()
 {
     auto buf = lock_buffer();
     auto msh = __mesh_root;
@@ -207,13 +218,13 @@ void brush::flush()
 
     if (m_state.mode == FX_TEXTURED_QUAD || m_state.mode == FX_COLORED_QUAD)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, msh->__ebo);
-        if (buf->__icap_changed)
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, buf->index_buf.capacity() * 4, buf->index_buf.data(), GL_STATIC_DRAW);
-        else
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, buf->index_buf.size() * 4, buf->index_buf.data());
+        unsigned int ibo = quad_index_buffer(buf->index_count / 6);
+        if (!msh->__quad_ibo_bound)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+            msh->__quad_ibo_bound = true;
+        }
     }
-    buf->__icap_changed = false;
     buf->dirty = false;
 
     switch (m_state.mode)
@@ -238,9 +249,9 @@ void brush::flush()
         prtlog_throw(FX_FATAL, "uknown graphics mode.");
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // the vao is unbound first, so that it keeps the quad index buffer.
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glUseProgram(0);
 
     if (__clear_when_flush)
@@ -251,7 +262,7 @@ void brush::assert_mode(graph_mode mode)
 {
     if (m_state.mode != mode)
     {
-        flush();
+        __flush_buffer();
         m_state.mode = mode;
     }
 }
@@ -267,17 +278,154 @@ void brush::assert_texture(shared<texture> tex)
 {
     if (__get_tex_root(m_state.texture) != __get_tex_root(tex))
     {
-        flush();
+        __flush_buffer();
         m_state.texture = tex;
     }
 }
 
-void brush::draw_texture(shared<texture> tex, const quad &dst, const quad &src, brush_flag flag)
+static unsigned int __get_program_root(shared<shader_program> program)
 {
-    if (tex == nullptr)
+    if (program == nullptr)
+        return 0;
+    return program->__program_id;
+}
+
+void brush::begin_deferred()
+{
+    if (__is_in_mesh)
+        prtlog_throw(FX_FATAL, "a mesh brush cannot defer draws.");
+    __flush_buffer();
+    __deferred = true;
+}
+
+void brush::end_deferred()
+{
+    flush();
+    __deferred = false;
+}
+
+void brush::layer(int l)
+{
+    __layer = l;
+}
+
+int brush::__dstate_index()
+{
+    if (__dstate_stale || __dstates.empty() || __dstates.back().texture != m_state.texture ||
+        __dstates.back().program != m_state.program)
+    {
+        __dstates.push_back(m_state);
+        __dstate_stale = false;
+    }
+    return (int)__dstates.size() - 1;
+}
+
+// write vertices, or queue them in deferred mode. #quad tells they are the 4 corners of a quad.
+template <typename V> void brush::__emit(V *vs, int n, bool quad)
+{
+    if (!__deferred)
+    {
+        auto buf = lock_buffer();
+        buf->push_vertices(std::span<const V>(vs, n));
+        if (quad)
+            buf->new_index(6);
         return;
+    }
+
+    // the transform stack may change before the queue is flushed, so positions are transformed now.
+    const transform &t = transform_stack.top();
+    for (int i = 0; i < n; i++)
+    {
+        float x = vs[i].x, y = vs[i].y;
+        vs[i].x = t.m00 * x + t.m01 * y + t.m02;
+        vs[i].y = t.m10 * x + t.m11 * y + t.m12;
+    }
+
+    __draw_cmd c;
+    c.layer = __layer;
+    c.program = __get_program_root(m_state.program);
+    c.texture = __get_tex_root(m_state.texture);
+    c.blend = __blend;
+    c.mode = m_state.mode;
+    c.state = __dstate_index();
+    c.offset = __dverts.size();
+    c.bytes = n * (int)sizeof(V);
+    c.vertices = n;
+    c.indices = quad ? 6 : 0;
+    const byte *src = reinterpret_cast<const byte *>(vs);
+    __dverts.insert(__dverts.end(), src, src + c.bytes);
+    __queue.push_back(c);
+}
+
+static bool __same_batch(const __draw_cmd &a, const __draw_cmd &b)
+{
+    return a.program == b.program && a.texture == b.texture && a.blend == b.blend && a.mode == b.mode;
+}
+
+void brush::__submit()
+{
+    std::stable_sort(__queue.begin(), __queue.end(), [](const __draw_cmd &a, const __draw_cmd &b) {
+        return std::tie(a.layer, a.program, a.texture, a.blend, a.mode) <
+               std::tie(b.layer, b.program, b.texture, b.blend, b.mode);
+    });
+
+    graph_state saved = m_state;
+    blend_mode saved_blend = __blend;
+    // in deferred mode, #use(blend_mode) does not touch gl, so the first batch sets it anyway.
+    bool blend_set = false;
+    // the positions are transformed already.
+    ts_load(transform());
+
     auto buf = lock_buffer();
+    for (size_t i = 0; i < __queue.size();)
+    {
+        size_t j = i + 1;
+        while (j < __queue.size() && __same_batch(__queue[i], __queue[j]))
+            j++;
+
+        // each change flushes the batch before.
+        const graph_state &st = __dstates[__queue[i].state];
+        use(st.program);
+        assert_texture(st.texture);
+        assert_mode(__queue[i].mode);
+        if (!blend_set || __queue[i].blend != __blend)
+        {
+            __flush_buffer();
+            __apply_blend(__queue[i].blend);
+            blend_set = true;
+        }
+        m_state.callback_uniform = st.callback_uniform;
 
+        size_t bytes = 0;
+        for (size_t k = i; k < j; k++)
+            bytes += __queue[k].bytes;
+        buf->__reserve_vtx(bytes);
+        for (size_t k = i; k < j; k++)
+        {
+            const __draw_cmd &c = __queue[k];
+            buf->vertex_buf.insert(buf->vertex_buf.end(), __dverts.begin() + c.offset,
+                                   __dverts.begin() + c.offset + c.bytes);
+            buf->new_vertex(c.vertices);
+            buf->new_index(c.indices);
+        }
+        buf->dirty = true;
+        i = j;
+    }
+    __flush_buffer();
+
+    ts_pop();
+    m_state = saved;
+    __apply_blend(saved_blend);
+    __queue.clear();
+    __dverts.clear();
+    __dstates.clear();
+    __dstate_stale = true;
+}
+
+void brush::draw_texture(shared<texture> tex, const quad &dst, const quad &src, brush_flag flag)
+{
+    if (tex == nullptr)
+        return;
     assert_mode(FX_TEXTURED_QUAD);
     assert_texture(tex);
 
@@ -297,23 +445,13 @@ void brush::draw_texture(shared<texture> tex, const quad &dst, const quad &src,
 
     float x = dst.x, y = dst.y, w = dst.width, h = dst.height;
 
-    buf->vtx(x + w).vtx(y + h);
-    __w_half(buf, vertex_color[2]);
-    buf->vtx(u2).vtx(v);
-
-    buf->vtx(x + w).vtx(y);
-    __w_half(buf, vertex_color[3]);
-    buf->vtx(u2).vtx(v2);
-
-    buf->vtx(x).vtx(y);
-    __w_half(buf, vertex_color[0]);
-    buf->vtx(u).vtx(v2);
-
-    buf->vtx(x).vtx(y + h);
-    __w_half(buf, vertex_color[1]);
-    buf->vtx(u).vtx(v);
-
-    buf->end_quad();
+    vertex_textured vs[4] = {
+        __vt(x + w, y + h, __vertex_half[2], u2, v),
+        __vt(x + w, y, __vertex_half[3], u2, v2),
+        __vt(x, y, __vertex_half[0], u, v2),
+        __vt(x, y + h, __vertex_half[1], u, v),
+    };
+    __emit(vs, 4, true);
 }
 
 void brush::draw_texture(shared<texture> tex, const quad &dst, brush_flag flag)
@@ -324,25 +462,17 @@ void brush::draw_texture(shared<texture> tex, const quad &dst, brush_flag flag)
 
 void brush::draw_rect(const quad &dst)
 {
-    auto buf = lock_buffer();
-
     assert_mode(FX_COLORED_QUAD);
 
     float x = dst.x, y = dst.y, w = dst.width, h = dst.height;
 
-    buf->vtx(x + w).vtx(y + h);
-    __w_half(buf, vertex_color[2]);
-
-    buf->vtx(x + w).vtx(y);
-    __w_half(buf, vertex_color[3]);
-
-    buf->vtx(x).vtx(y);
-    __w_half(buf, vertex_color[0]);
-
-    buf->vtx(x).vtx(y + h);
-    __w_half(buf, vertex_color[1]);
-
-    buf->end_quad();
+    vertex_colored vs[4] = {
+        __vc(x + w, y + h, __vertex_half[2]),
+        __vc(x + w, y, __vertex_half[3]),
+        __vc(x, y, __vertex_half[0]),
+        __vc(x, y + h, __vertex_half[1]),
+    };
+    __emit(vs, 4, true);
 }
 
 void brush::draw_rect_outline(const quad &dst)
@@ -360,41 +490,33 @@ void brush::draw_rect_outline(const quad &dst)
 
 void brush::draw_triagle(const vec2 &p1, const vec2 &p2, const vec2 &p3)
 {
-    auto buf = lock_buffer();
-
     assert_mode(FX_COLORED_TRIANGLE);
 
-    buf->vtx(float(p1.x)).vtx(float(p1.y));
-    __w_half(buf, vertex_color[0]);
-    buf->vtx(float(p2.x)).vtx(float(p2.y));
-    __w_half(buf, vertex_color[1]);
-    buf->vtx(float(p3.x)).vtx(float(p3.y));
-    __w_half(buf, vertex_color[2]);
-    buf->new_vertex(3);
+    vertex_colored vs[3] = {
+        __vc(p1.x, p1.y, __vertex_half[0]),
+        __vc(p2.x, p2.y, __vertex_half[1]),
+        __vc(p3.x, p3.y, __vertex_half[2]),
+    };
+    __emit(vs, 3, false);
 }
 
 void brush::draw_line(const vec2 &p1, const vec2 &p2)
 {
-    auto buf = lock_buffer();
-
     assert_mode(FX_COLORED_LINE);
 
-    buf->vtx(float(p1.x)).vtx(float(p1.y));
-    __w_half(buf, vertex_color[0]);
-    buf->vtx(float(p2.x)).vtx(float(p2.y));
-    __w_half(buf, vertex_color[1]);
-    buf->new_vertex(2);
+    vertex_colored vs[2] = {
+        __vc(p1.x, p1.y, __vertex_half[0]),
+        __vc(p2.x, p2.y, __vertex_half[1]),
+    };
+    __emit(vs, 2, false);
 }
 
 void brush::draw_point(const vec2 &p)
 {
-    auto buf = lock_buffer();
-
     assert_mode(FX_COLORED_POINT);
 
-    buf->vtx(float(p.x)).vtx(float(p.y));
-    __w_half(buf, vertex_color[0]);
-    buf->new_vertex(1);
+    vertex_colored vs[1] = {__vc(p.x, p.y, __vertex_half[0])};
+    __emit(vs, 1, false);
 }
 
 void brush::draw_oval(const quad &dst, int segs)
@@ -466,7 +588,19 @@ void brush::scissor_end()
 
 void brush::use(blend_mode mode)
 {
+    // queued draws keep the mode they are made in, and it is applied when they are flushed.
+    if (__deferred)
+    {
+        __blend = mode;
+        return;
+    }
     flush();
+    __apply_blend(mode);
+}
+
+void brush::__apply_blend(blend_mode mode)
+{
+    __blend = mode;
     if (mode == FX_NORMAL_BLEND)
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     else if (mode == FX_ADDITIVE_BLEND)
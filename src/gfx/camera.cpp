@@ -1,5 +1,6 @@
 #include <gfx/camera.h>
 #include <gfx/gfx.h>
+#include <algorithm>
 
 namespace flux::gfx
 {
@@ -71,6 +72,41 @@ void camera::unproject(vec2 &v)
     inverted_t.apply(v);
 }
 
+// the viewport mapping, folded into a transform: [-1, 1] to the viewport rect.
+static transform __viewport_t(const quad &vp)
+{
+    float hw = vp.width / 2, hh = vp.height / 2;
+    return transform(hw, 0, hw + vp.x, 0, hh, hh + vp.y);
+}
+
+void camera::project_many(const float *xy_in, float *xy_out, int n)
+{
+    if (viewport.width <= 0 || viewport.height <= 0)
+    {
+        // avoid NaN problem
+        if (xy_out != xy_in)
+            std::copy(xy_in, xy_in + n * 2, xy_out);
+        return;
+    }
+    transform t = __viewport_t(viewport);
+    t.multiply(combined_t);
+    t.apply_many(xy_in, xy_out, n);
+}
+
+void camera::unproject_many(const float *xy_in, float *xy_out, int n)
+{
+    if (viewport.width <= 0 || viewport.height <= 0)
+    {
+        // avoid NaN problem
+        if (xy_out != xy_in)
+            std::copy(xy_in, xy_in + n * 2, xy_out);
+        return;
+    }
+    transform t = inverted_t;
+    t.multiply(__viewport_t(viewport).get_invert());
+    t.apply_many(xy_in, xy_out, n);
+}
+
 double camera::project_x(double x)
 {
     vec2 v = vec2(x, 0);
@@ -1,32 +1,17 @@
 #include <gfx/cbuf.h>
 #include <gl/glew.h>
 #include <gl/gl.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace flux::gfx
 {
 
 void complex_buffer::end_quad()
 {
-    new_index(6);
     new_vertex(4);
-
-    std::size_t s = sizeof(unsigned int) * 6;
-    std::size_t old = index_buf.size();
-    if (old + s > index_buf.capacity())
-    {
-        index_buf.reserve(index_buf.capacity() * 2);
-        __icap_changed = true;
-    }
-
-    unsigned int k = vertex_count - 4;
-    // we don't use #idx to cut down 5 another cap checks.
-    index_buf.push_back(0 + k);
-    index_buf.push_back(1 + k);
-    index_buf.push_back(3 + k);
-    index_buf.push_back(1 + k);
-    index_buf.push_back(2 + k);
-    index_buf.push_back(3 + k);
+    new_index(6);
 }
 
 void complex_buffer::new_vertex(int count)
@@ -42,7 +27,6 @@ void complex_buffer::new_index(int count)
 void complex_buffer::clear()
 {
     vertex_buf.clear();
-    index_buf.clear();
     vertex_count = 0;
     index_count = 0;
     dirty = true;
@@ -53,4 +37,33 @@ shared<complex_buffer> make_buffer()
     return std::make_shared<complex_buffer>();
 }
 
+static unsigned int __quad_ibo = 0;
+static int __quad_ibo_quads = 0;
+
+unsigned int quad_index_buffer(int quads)
+{
+    if (__quad_ibo == 0)
+        glGenBuffers(1, &__quad_ibo);
+    if (quads <= __quad_ibo_quads)
+        return __quad_ibo;
+
+    int n = std::max({quads, __quad_ibo_quads * 2, 4096});
+    std::vector<unsigned int> idx(size_t(n) * 6);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned int k = i * 4;
+        unsigned int *q = idx.data() + size_t(i) * 6;
+        q[0] = k + 0;
+        q[1] = k + 1;
+        q[2] = k + 3;
+        q[3] = k + 1;
+        q[4] = k + 2;
+        q[5] = k + 3;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, __quad_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(unsigned int), idx.data(), GL_STATIC_DRAW);
+    __quad_ibo_quads = n;
+    return __quad_ibo;
+}
+
 } // namespace flux
\ No newline at end of file
@@ -16,7 +16,6 @@ mesh::~mesh()
 {
     glDeleteVertexArrays(1, &__vao);
     glDeleteBuffers(1, &__vbo);
-    glDeleteBuffers(1, &__ebo);
 }
 
 brush *mesh::retry()
@@ -36,6 +35,8 @@ void mesh::record()
 
 void mesh::draw(brush *gbrush)
 {
+    // draws queued in deferred mode go first, into the brush's own buffer.
+    gbrush->flush();
     auto old_state = gbrush->m_state;
     auto old_buf = gbrush->buffer;
     auto old_msh = gbrush->__mesh_root;
@@ -58,13 +59,11 @@ shared<mesh> make_mesh()
     shared<mesh> msh = std::make_unique<mesh>();
     shared<complex_buffer> buf = msh->buffer;
 
-    unsigned int vao, vbo, ebo;
+    unsigned int vao, vbo;
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
     msh->__vao = vao;
     msh->__vbo = vbo;
-    msh->__ebo = ebo;
 
     return msh;
 }
@@ -1,4 +1,5 @@
 #include <gfx/shader.h>
+#include <gfx/vertex.h>
 #include <core/def.h>
 #include <memory>
 #include <gl/glew.h>
@@ -93,6 +94,15 @@ shader_attrib shader_program::get_attrib(int index)
     return {index};
 }
 
+void shader_program::layout(const vertex_format &fmt)
+{
+    for (int i = 0; i < fmt.count; i++)
+    {
+        const vertex_attrib &a = fmt.attribs[i];
+        get_attrib(i).layout(a.type, a.components, fmt.stride, a.offset, a.normalize);
+    }
+}
+
 shader_uniform shader_program::get_uniform(const std::string &name)
 {
     return {glGetUniformLocation(__program_id, name.c_str())};
@@ -200,17 +210,14 @@ shared<shader_program> make_program(builtin_shader_type type)
     if (__builtin_colored == nullptr || __builtin_textured == nullptr)
     {
         __builtin_colored = make_program(__dvert_colored, __dfrag_colored, [](shared<shader_program> program) {
-            program->get_attrib(0).layout(FX_VDAT_FLOAT, 2, 16, 0);
-            program->get_attrib(1).layout(FX_VDAT_HALF_FLOAT, 4, 16, 8);
+            program->layout(vertex_colored::format);
 
             if (program->cached_uniforms.size() > 0)
                 return;
             program->cache_uniform("u_proj"); // 0
         });
         __builtin_textured = make_program(__dvert_textured, __dfrag_textured, [](shared<shader_program> program) {
-            program->get_attrib(0).layout(FX_VDAT_FLOAT, 2, 24, 0);
-            program->get_attrib(1).layout(FX_VDAT_HALF_FLOAT, 4, 24, 8);
-            program->get_attrib(2).layout(FX_VDAT_FLOAT, 2, 24, 16);
+            program->layout(vertex_textured::format);
 
             if (program->cached_uniforms.size() > 0)
                 return;
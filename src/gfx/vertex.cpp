@@ -0,0 +1,122 @@
+#include <gfx/vertex.h>
+#include <core/simd.h>
+#include <cstring>
+
+namespace flux::gfx
+{
+
+// the magic numbers of the conversion below, as float bits.
+// values at or over F16_MAX overflow to infinity, under NORM_MIN they are denormals in half.
+static constexpr uint32_t __F32_INF = 255u << 23;
+static constexpr uint32_t __F16_MAX = (127u + 16) << 23;
+static constexpr uint32_t __NORM_MIN = 113u << 23;
+// adding it as a float shifts the mantissa of a small value into place, rounded by the fpu.
+static constexpr uint32_t __DENORM_MAGIC = ((127u - 15) + (23 - 10) + 1) << 23;
+
+// rounds to nearest even, keeps denormals, and maps nan to a quiet nan. like what f16c does.
+half to_half(float f)
+{
+    uint32_t u;
+    std::memcpy(&u, &f, 4);
+    uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    uint32_t o;
+    if (u >= __F16_MAX)
+        o = u > __F32_INF ? 0x7E00 : 0x7C00;
+    else if (u < __NORM_MIN)
+    {
+        float magic, v;
+        std::memcpy(&magic, &__DENORM_MAGIC, 4);
+        std::memcpy(&v, &u, 4);
+        v += magic;
+        std::memcpy(&u, &v, 4);
+        o = u - __DENORM_MAGIC;
+    }
+    else
+    {
+        uint32_t odd = (u >> 13) & 1;
+        // rebias the exponent, and round: 0xFFF plus the lowest kept bit rounds ties to even.
+        u += ((15u - 127u) << 23) + 0xFFF + odd;
+        o = u >> 13;
+    }
+    return half(o | (sign >> 16));
+}
+
+#if defined(FX_X86)
+
+FX_TARGET("avx,f16c") static int __to_half_f16c(const float *in, half *out, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), h);
+    }
+    return i;
+}
+
+#endif
+
+#if defined(FX_X86) && defined(__SSE2__)
+
+// #to_half on 4 lanes, with the branches turned into selects.
+static int __to_half_sse2(const float *in, half *out, int n)
+{
+    const __m128i sign_mask = _mm_set1_epi32((int)0x80000000u);
+    const __m128i f32_inf = _mm_set1_epi32(__F32_INF);
+    const __m128i f16_max = _mm_set1_epi32(__F16_MAX);
+    const __m128i norm_min = _mm_set1_epi32(__NORM_MIN);
+    const __m128i magic = _mm_set1_epi32(__DENORM_MAGIC);
+    const __m128i rebias = _mm_set1_epi32(((15u - 127u) << 23) + 0xFFF);
+    const __m128i one = _mm_set1_epi32(1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i r[2];
+        for (int k = 0; k < 2; k++)
+        {
+            __m128i u = _mm_castps_si128(_mm_loadu_ps(in + i + k * 4));
+            __m128i sign = _mm_and_si128(u, sign_mask);
+            u = _mm_xor_si128(u, sign);
+
+            // the sign is cleared, so signed compares work.
+            __m128i big = _mm_cmpgt_epi32(u, _mm_sub_epi32(f16_max, one));
+            __m128i nan = _mm_cmpgt_epi32(u, f32_inf);
+            __m128i tiny = _mm_cmplt_epi32(u, norm_min);
+
+            __m128i inf = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(nan, _mm_set1_epi32(0x0200)));
+            __m128i den = _mm_sub_epi32(
+                _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(u), _mm_castsi128_ps(magic))), magic);
+            __m128i odd = _mm_and_si128(_mm_srli_epi32(u, 13), one);
+            __m128i nrm = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u, rebias), odd), 13);
+
+            __m128i o = _mm_or_si128(_mm_and_si128(tiny, den), _mm_andnot_si128(tiny, nrm));
+            o = _mm_or_si128(_mm_and_si128(big, inf), _mm_andnot_si128(big, o));
+            o = _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+            // sign-extend the low 16 bits, so the saturating pack keeps them as they are.
+            r[k] = _mm_srai_epi32(_mm_slli_epi32(o, 16), 16);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(r[0], r[1]));
+    }
+    return i;
+}
+
+#endif
+
+void to_half_many(const float *in, half *out, int n)
+{
+    int i = 0;
+#if defined(FX_X86)
+    if (cpu_has_f16c())
+        i = __to_half_f16c(in, out, n);
+#endif
+#if defined(FX_X86) && defined(__SSE2__)
+    if (i == 0)
+        i = __to_half_sse2(in, out, n);
+#endif
+    for (; i < n; i++)
+        out[i] = to_half(in[i]);
+}
+
+} // namespace flux::gfx
@@ -11,6 +11,7 @@
 #include <core/bio.h>
 #include <core/load.h>
 #include <core/rand.h>
+#include <core/noise.h>
 #include <core/uuid.h>
 #include <net/packet.h>
 #include <net/socket.h>
@@ -22,8 +23,35 @@ using namespace flux::net;
 using namespace flux::au;
 
 #define NET_TEST
+// define it to time noise::generate_grid against per-sample noise::generate, instead of running the game.
+// #define NOISE_BENCH
 
-#ifndef NET_TEST
+#if defined(NOISE_BENCH)
+
+int main()
+{
+    const int n = 256, rounds = 64;
+    const vec3 origin(-1024.3, 517.7, 0.25), step(1 / 32.0, 1 / 32.0, 1);
+    auto perlin = make_perlin(114514);
+    std::vector<float> slow(n * n), fast(n * n);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        perlin->noise::generate_grid(origin, step, n, n, 1, slow.data());
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        perlin->generate_grid(origin, step, n, n, 1, fast.data());
+    auto t2 = std::chrono::steady_clock::now();
+
+    double diff = 0;
+    for (int i = 0; i < n * n; i++)
+        diff = std::max(diff, (double)std::abs(slow[i] - fast[i]));
+    auto us = [](auto d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count() / rounds; };
+    prtlog(FX_INFO, "perlin {}x{}: per-sample {}us, grid {}us, max diff {}", n, n, us(t1 - t0), us(t2 - t1), diff);
+    return 0;
+}
+
+#elif !defined(NET_TEST)
 shared<texture> tex, tex1;
 shared<mesh> msh;
 shared<font> fnt;
@@ -34,6 +62,9 @@ int main()
 
     loader = make_loader({"enchant"}, hio_open_local(""));
     make_loader_equipment(loader, FX_LOAD_PNG_AS_TEXTURE);
+    loader->event_on_task = [](const res_id &id, std::chrono::microseconds decode, std::chrono::microseconds fin) {
+        prtlog(FX_DEBUG, "loaded {} (decode: {}us, finalize: {}us)", std::string(id), decode.count(), fin.count());
+    };
     loader->scan(hio_open_local(""));
 
     /*
@@ -65,9 +96,9 @@ int main()
     fnt = load_font(hio_open_local("gfx/font/fusion_pixel.ttf"), 12, 12);
 
     tk_hook_event_tick([]() {
-        while (loader->progress < 1)
+        if (loader->progress < 1)
         {
-            loader->next();
+            loader->next_for(std::chrono::milliseconds(8));
             prtlog(FX_INFO, "load: " + std::to_string(loader->progress));
         }
         tk_title(fmt::format("Enchant Flux | tps :{} fps :{}", tk_real_tps(), tk_real_fps()));